@@ -0,0 +1,118 @@
+#ifndef BUS_EXECUTOR_HPP
+#define BUS_EXECUTOR_HPP
+
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <chrono>
+
+#include "powerboard_backend.hpp"
+#include "bus_metrics.hpp"
+
+/*
+*  Single owner of the I2C bus backend. All driver calls are submitted as commands and executed
+*  one by one on the bus thread, ordered by priority and FIFO within the same priority.
+*/
+class BusExecutor
+{
+    public:
+        //  ******* constants ********
+        enum Priority
+        {
+            PRIORITY_STATUS = 0,        //shutdown and board status
+            PRIORITY_LED = 1,           //led frames and configuration
+            PRIORITY_TELEMETRY = 2,     //esc telemetry
+            PRIORITY_COUNT = 3,
+        };
+        //status returned when command could not be executed (bus not running or no backend)
+        static const uint8_t STATUS_NOT_RUNNING = 0xff;
+
+        //command returns driver status, 0 means success
+        typedef std::function<uint8_t(PowerboardBackend &board)> Command;
+
+        struct QueueStats
+        {
+            uint32_t depth;             //commands waiting right now
+            uint32_t max_depth;         //max commands waiting since last read
+            uint64_t executed;          //commands executed since start
+            double avg_wait_s;          //average time in queue since last read
+            double max_wait_s;          //max time in queue since last read
+        };
+
+        //  ******* methods *******
+        BusExecutor();
+        ~BusExecutor();
+
+        //takes ownership of backend, must be set before Open, every call is measured
+        void SetBackend(PowerboardBackend *backend);
+        BusMetrics &Metrics();
+        bool IsSimulated() const;
+        //open port, returns true on error
+        bool Open(const std::string &port);
+        void Close();
+        void Start();
+        void Stop();
+
+        //submit command and wait for its status
+        uint8_t Execute(Priority priority, const Command &command);
+        //submit command without waiting, returns STATUS_NOT_RUNNING when command was dropped
+        uint8_t Post(Priority priority, const Command &command);
+        //submit command without waiting, it is queued after delay_s, returns STATUS_NOT_RUNNING when command was dropped
+        uint8_t PostDelayed(Priority priority, double delay_s, const Command &command);
+
+        //read statistics of priority queue, window values are reset
+        QueueStats ReadStats(Priority priority);
+        static const char *PriorityName(Priority priority);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Task
+        {
+            Command command;
+            std::shared_ptr<std::promise<uint8_t> > result;
+            Clock::time_point submitted;
+        };
+
+        struct DeferredTask
+        {
+            Priority priority;
+            Command command;
+        };
+
+        struct QueueCounters
+        {
+            uint32_t max_depth;
+            uint64_t executed;
+            uint64_t window_executed;
+            double window_wait_s;
+            double max_wait_s;
+        };
+
+        //  ******* properties ********
+        //i2c
+        BusMetrics metrics_;
+        PowerboardBackend *backend_;
+        //queue
+        std::deque<Task> queues_[PRIORITY_COUNT];
+        std::multimap<Clock::time_point, DeferredTask> deferred_;
+        QueueCounters counters_[PRIORITY_COUNT];
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::thread thread_;
+        bool running_;
+
+        //  ******* methods *******
+        uint8_t Submit(Priority priority, const Command &command, const std::shared_ptr<std::promise<uint8_t> > &result);
+        void Enqueue(Priority priority, const Command &command, const std::shared_ptr<std::promise<uint8_t> > &result);
+        void Run();
+};
+
+#endif //BUS_EXECUTOR_HPP
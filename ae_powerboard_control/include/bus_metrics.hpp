@@ -0,0 +1,134 @@
+#ifndef BUS_METRICS_HPP
+#define BUS_METRICS_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+#include "powerboard_backend.hpp"
+
+#define BUS_METRICS_BUCKETS 24     //log2 buckets in us, last one covers everything from 2^22 us (about 4.2 s)
+
+/*
+*  Lock-free latency histograms of every backend operation.
+*  Written only by bus thread, read from any thread.
+*/
+class BusMetrics
+{
+    public:
+        //  ******* constants ********
+        enum Operation
+        {
+            OP_STATUS_GET = 0,
+            OP_BOARD_INFO_GET,
+            OP_TURN_OFF,
+            OP_ESC_ERROR_LOG,
+            OP_ESC_DATA_LOG,
+            OP_ESC_DEVICE_INFO,
+            OP_ESC_RESISTANCE,
+            OP_LEDS_SWITCH_PREDEFINED,
+            OP_LEDS_GET_COUNT,
+            OP_LEDS_SET_COUNT,
+            OP_LEDS_SEND_BUFFER,
+            OP_LEDS_UPDATE,
+            OP_LEDS_SET_PREDEFINED,
+            OP_COUNT,
+        };
+
+        struct Histogram
+        {
+            uint64_t count;
+            uint64_t errors;
+            uint64_t sum_ns;
+            uint64_t buckets[BUS_METRICS_BUCKETS];
+        };
+
+        //copy of all counters in one moment
+        struct Snapshot
+        {
+            std::chrono::steady_clock::time_point time;
+            uint64_t busy_ns;
+            Histogram operations[OP_COUNT];
+        };
+
+        struct Summary
+        {
+            uint64_t count;
+            uint64_t errors;
+            double mean_s;
+            double p50_s;
+            double p99_s;
+        };
+
+        //  ******* methods *******
+        BusMetrics();
+
+        void Record(Operation operation, uint64_t duration_ns, uint8_t status);
+        Snapshot Read() const;
+        //max since start, and since last call of ReadWindowMax
+        double ReadMax(Operation operation) const;
+        double ReadWindowMax(Operation operation);
+
+        static Summary Summarize(const Histogram &now, const Histogram &before);
+        static double BusyFraction(const Snapshot &now, const Snapshot &before);
+        static const char *OperationName(Operation operation);
+
+    private:
+        struct Counters
+        {
+            std::atomic<uint64_t> count;
+            std::atomic<uint64_t> errors;
+            std::atomic<uint64_t> sum_ns;
+            std::atomic<uint64_t> max_ns;
+            std::atomic<uint64_t> window_max_ns;
+            std::atomic<uint64_t> buckets[BUS_METRICS_BUCKETS];
+        };
+
+        //  ******* properties ********
+        std::chrono::steady_clock::time_point start_;
+        std::atomic<uint64_t> busy_ns_;
+        Counters operations_[OP_COUNT];
+
+        //  ******* methods *******
+        static uint8_t Bucket(uint64_t duration_ns);
+        static double Percentile(const uint64_t *buckets, uint64_t count, double percentile);
+};
+
+/*
+*  Backend decorator which measures every call of wrapped backend.
+*/
+class MeteredBackend : public PowerboardBackend
+{
+    private:
+        //  ******* properties ********
+        PowerboardBackend *backend_;
+        BusMetrics &metrics_;
+
+    public:
+        //  ******* methods *******
+        //takes ownership of backend
+        MeteredBackend(PowerboardBackend *backend, BusMetrics &metrics);
+        ~MeteredBackend();
+
+        bool Open(const std::string &port);
+        void Close();
+        bool IsSimulated() const;
+
+        uint8_t PowerBoardStatusGet(uint8_t *status);
+        uint8_t PowerBoardInfoGet(POWER_BOARD_INFO *info);
+        uint8_t DroneTurnOff();
+        uint8_t EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc);
+        uint8_t EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc);
+        uint8_t EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc);
+        uint8_t EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc);
+
+        uint8_t LedsSwitchPredefinedEffect(bool enable);
+        uint8_t LedsGetLedsCount(LEDS_COUNT &leds_count);
+        uint8_t LedsSetLedsCount(LEDS_COUNT leds_count);
+        uint8_t LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count);
+        uint8_t LedsUpdate();
+        uint8_t LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+            uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default);
+};
+
+#endif //BUS_METRICS_HPP
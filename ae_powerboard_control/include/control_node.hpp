@@ -5,10 +5,22 @@
 
 #include <linux/reboot.h>
 #include <sys/reboot.h>
+#include <deque>
+#include <vector>
+#include <boost/make_shared.hpp>
 
 #include "utils.hpp"
-#include "i2c_driver.h" 
-#include "pb6s40a_control.h"
+#include "bus_executor.hpp"
+#include "led_output.hpp"
+#include "led_effect.hpp"
+#include "simulated_backend.hpp"
+#include "telemetry_scheduler.hpp"
+#include "telemetry_store.hpp"
+#include "telemetry_refresh.hpp"
+#include "flight_recorder.hpp"
+#include "led_mailbox.hpp"
+#include "led_compositor.hpp"
+#include "led_status.hpp"
 
 #include "std_srvs/SetBool.h"
 #include "ae_powerboard_control/GetEscDeviceInfo.h"
@@ -20,26 +32,66 @@
 #include "ae_powerboard_control/SetLedPredefinedEffect.h"
 #include "ae_powerboard_control/SetLedCustomEffect.h"
 #include "ae_powerboard_control/GetEscResistance.h"
+#include "ae_powerboard_control/BusQueueStats.h"
+#include "ae_powerboard_control/LedOutputStats.h"
+#include "ae_powerboard_control/GetBusStats.h"
+#include "ae_powerboard_control/EscErrorLogs.h"
+#include "ae_powerboard_control/EscDataLogs.h"
+#include "ae_powerboard_control/EscDevicesInfo.h"
+#include "ae_powerboard_control/EscResistances.h"
+#include "ae_powerboard_control/EscFaultEvents.h"
+#include "ae_powerboard_control/PowerboardState.h"
+#include "ae_powerboard_control/LedStreamFrame.h"
+#include "ae_powerboard_control/SetLedLayer.h"
+#include "ae_powerboard_control/LedColorCommand.h"
+#include "ae_powerboard_control/LedCustomColorCommand.h"
+#include "ae_powerboard_control/LedPredefinedEffectCommand.h"
+#include "ae_powerboard_control/LedCustomEffectCommand.h"
+#include "ae_powerboard_control/LedCommandStatus.h"
 
 #define DEVICE_I2C_NANO     "/dev/i2c-1"
 #define DEVICE_I2C_NX       "/dev/i2c-8"
 
 #define MAIN_TIME_PERIOD_S  0.05
 #define STATE_TIME_PERIOD_S 1
-#define LED_COUNT_EFFECT    8
+#define STATS_TIME_PERIOD_S 1
+#define TELEMETRY_TIME_PERIOD_S 0.005
+#define POWERBOARD_STATE_DEFAULT_RATE 1.0
+
+#define LED_DEFAULT_CAPACITY        256
+#define LED_COMMAND_TIMEOUT_S       1.0
+
+#define RECORDER_DEFAULT_DIR        "/var/tmp"
+#define RECORDER_DEFAULT_PATH       RECORDER_DEFAULT_DIR "/ae_powerboard_control.rec"
+#define RECORDER_DEFAULT_RECORDS    65536
+
+/*
+*  Board handled by one Control, single board without name keeps names of topics, services and params.
+*/
+struct ControlBoard
+{
+    std::string name;
+    std::string port;
+};
 
 class Control
 {
     private:
-        //  ******* constants ********
-        enum Effect_Type
+        //led command from topic, its result is published when ticket is written
+        struct LedTopicCommand
         {
-            NO_EFFECT = 0,
-            EFFECT_1 = 1,
+            uint64_t ticket;
+            uint8_t command;
+            uint32_t id;
         };
+
         //  ******* properties ********
         // ros node
         ros::NodeHandle nh_;
+        //parameters, node namespace of executable or nodelet namespace
+        ros::NodeHandle private_nh_;
+        //board name, empty for single board
+        std::string name_;
         // ros servers
         ros::ServiceServer esc_dev_info_srv_;
         ros::ServiceServer esc_error_log_srv_;
@@ -50,48 +102,123 @@ class Control
         ros::ServiceServer led_set_color_srv_;
         ros::ServiceServer led_set_custom_effect_srv_;
         ros::ServiceServer led_set_predefined_effect_srv_;
+        ros::ServiceServer led_set_layer_srv_;
         ros::ServiceServer board_shutdown_srv_;
+        ros::ServiceServer bus_stats_srv_;
+        // ros publishers
+        ros::Publisher bus_stats_pub_;
+        ros::Publisher led_stats_pub_;
+        ros::Publisher bus_metrics_pub_;
+        ros::Publisher esc_error_log_pub_;
+        ros::Publisher esc_data_log_pub_;
+        ros::Publisher esc_dev_info_pub_;
+        ros::Publisher esc_resistance_pub_;
+        ros::Publisher esc_fault_events_pub_;
+        ros::Publisher powerboard_state_pub_;
+        ros::Publisher led_command_status_pub_;
+        // ros subscribers
+        ros::Subscriber led_stream_sub_;
+        ros::Subscriber led_color_cmd_sub_;
+        ros::Subscriber led_custom_color_cmd_sub_;
+        ros::Subscriber led_predefined_effect_cmd_sub_;
+        ros::Subscriber led_custom_effect_cmd_sub_;
         // ros timers
         ros::Timer main_tim_;
         ros::Timer state_tim_;
+        ros::Timer stats_tim_;
+        ros::Timer telemetry_tim_;
+        ros::Timer powerboard_state_tim_;
+        //timer rates in Hz, params are checked every stats period and applied while running
+        double led_rate_;
+        std::atomic<double> led_period_s_;
+        double board_status_rate_;
+        double state_rate_;
+        //telemetry rates are moved to scheduler on telemetry timer
+        std::mutex telemetry_rates_mutex_;
+        double telemetry_rates_[TELEMETRY_CLASS_COUNT];
+        //bit per telemetry class whose rate changed
+        std::atomic<uint8_t> telemetry_rates_changed_;
         //i2c
-        I2CDriver i2c_driver_;
+        BusExecutor bus_;
         std::string i2c_port_;
         bool i2c_error_;
-        Pb6s40aDroneControl *drone_control_;
-        Pb6s40aLedsControl *led_control_;
-        // **esc**
-        //esc error log
-        ERROR_WARN_LOG esc_error_log_[4];
-        uint8_t esc_error_log_status_;
-        //esc data log
-        RUN_DATA_Struct esc_data_log_[4];
-        uint8_t esc_data_log_status_;
-        //esc device info
-        ADB_DEVICE_INFO esc_device_info_[4];
-        uint8_t esc_device_info_status_;
-        //esc resistance 
-        RESISTANCE_STRUCT esc_resistance_[4];
-        uint8_t esc_restistance_status_;
-        // **board**
-        //board device info
-        POWER_BOARD_INFO board_device_info_;
-        bool board_device_info_status_;
+        bool board_status_error_;
+        BusMetrics::Snapshot bus_metrics_start_;
+        BusMetrics::Snapshot bus_metrics_last_;
+        // **esc and board**
+        //esc logs, device info, resistance and board status, written only on bus thread
+        TelemetryStore telemetry_;
+        //esc telemetry polling
+        TelemetryScheduler telemetry_scheduler_;
+        //on-demand reads from services
+        TelemetryRefresh telemetry_refresh_;
+        //flight recorder, last recorded samples are used only on bus thread
+        FlightRecorder recorder_;
+        FlightRecord recorded_esc_error_log_[TELEMETRY_ESC_COUNT];
+        FlightRecord recorded_esc_data_log_[TELEMETRY_ESC_COUNT];
+        FlightRecord recorded_board_status_;
         // **led**
         LEDS_COUNT mounted_leds_count_;
-        //led effect
-        bool led_effect_run_;
-        bool led_effect_update_;
+        //leds per channel, requests are checked against it and buffers are sized by it
+        uint16_t led_capacity_;
+        //led service requests and topic commands, led_command_frame_ is filled by callbacks under
+        //led_command_frame_mutex_ and swapped into mailbox, led_request_frame_ is used only on bus thread
+        std::mutex led_command_frame_mutex_;
+        LedFrame led_command_frame_;
+        LedMailbox led_command_mailbox_;
+        LedFrame led_request_frame_;
+        //led topic commands waiting for their result, ordered by ticket
+        std::mutex led_topic_mutex_;
+        std::deque<LedTopicCommand> led_topic_commands_;
+        //led layers and output, used only on bus thread
+        LedCompositor led_compositor_;
+        LedOutput led_output_;
+        LedFrame led_layer_frame_;
+        //led effect, flags are set from callbacks and read on main timer,
+        //requested type and start are handed over under led_effect_mutex_
+        std::atomic<bool> led_effect_run_;
+        std::atomic<bool> led_effect_update_;
+        std::mutex led_effect_mutex_;
         uint8_t led_effect_type_;
-        //board status
-        uint8_t power_board_status_;
+        ros::Time led_effect_start_;
+        //common start of all effects, zero starts effect when requested
+        ros::Time led_effect_epoch_;
+        LedEffectLibrary led_effects_;
+        //auto dim, used only on main timer
+        double led_brightness_;
+        double led_dim_start_s_;
+        double led_dim_ramp_s_;
+        double led_dim_brightness_;
+        std::atomic<uint8_t> led_brightness_level_;
+        ros::Time led_start_time_;
+        //esc health on arms, used only on telemetry timer
+        LedStatus led_status_;
+        LedFrame led_status_frame_;
+        //playback state, used only on main timer
+        LedEffectPlayer led_effect_player_;
+        LedFrame led_effect_frame_;
+        //streamed frames, led_stream_input_frame_ is used only on stream subscriber, led_stream_frame_ only on bus thread
+        LedMailbox led_mailbox_;
+        LedFrame led_stream_input_frame_;
+        LedFrame led_stream_frame_;
 
         //  ******* methods *******
         // init
         void Init();
         void DefaultValues();
+        void ConfigureLedColor();
+        void AllocateLedBuffers();
         void SetupServices();
+        void SetupPublishers();
+        void SetupSubscribers();
         void SetupTimers();
+        //returns true when param holds new valid rate
+        bool ReadRate(const std::string &name, double &rate, bool allow_zero);
+        void SetTimerRate(ros::Timer &timer, double rate);
+        void UpdateRates();
+        // recorder
+        void OpenRecorder();
+        void RecordLedFrame(uint8_t command, const LedFrame &frame);
         // i2c
         void OpenI2C();
         void CloseI2C();
@@ -102,9 +229,33 @@ class Control
         void GetEscDataLog();
         void GetEscDeviceInfo();
         void GetEscResistance();
+        bool ReadEscErrorLog(uint8_t i, bool verbose);
+        bool ReadEscDataLog(uint8_t i, bool verbose);
+        bool ReadEscDeviceInfo(uint8_t i, bool verbose);
+        bool ReadEscResistance(uint8_t i, bool verbose);
+        bool ReadEsc(uint8_t data_class, uint8_t i, bool verbose);
+        uint8_t RequestedEscMask(const std::vector<uint8_t> &esc_numbers);
+        void RefreshEsc(uint8_t data_class, uint8_t esc_mask, double max_age, bool force_refresh);
+        void FillEscErrorLog(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscErrorLog> &error_logs);
+        void FillEscDataLog(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscDataLog> &data_logs);
+        void FillEscDeviceInfo(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscDeviceInfo> &devices_info);
+        void FillEscResistance(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscResistance> &resistances);
+        void FillEscDeviceInfo(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscDeviceInfo &dev_info);
+        void FillEscErrorLog(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscErrorLog &error_log);
+        void FillEscDataLog(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscDataLog &data_log);
+        void FillEscResistance(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscResistance &resistance);
+        void SetupTelemetry();
+        void PublishTelemetry(uint8_t data_class);
+        void PublishFaultEvents(uint8_t i, const ERROR_WARN_LOG &previous, const ERROR_WARN_LOG &current, const ros::Time &stamp);
+        static void AppendFaultEvents(std::vector<ae_powerboard_control::EscFaultEvent> &events, uint8_t log, bool warning, uint32_t previous, uint32_t current);
         //Board
         void GetBoardDeviceInfo();
+        bool ReadBoardDeviceInfo(bool verbose);
+        void FillBoardDeviceInfo(const TelemetrySnapshot &telemetry, ae_powerboard_control::BoardDeviceInfo &dev_info);
         bool CallbackBoardShutdown(std_srvs::SetBool::Request &req, std_srvs::SetBool::Response &res);
+        //Bus
+        void FillBusStats(ae_powerboard_control::BusStats &msg, const BusMetrics::Snapshot &now, const BusMetrics::Snapshot &before, bool window);
+        bool CallbackBusStats(ae_powerboard_control::GetBusStats::Request &req, ae_powerboard_control::GetBusStats::Response &res);
         //Callback for service
         bool CallbackEscDeviceInfo(ae_powerboard_control::GetEscDeviceInfo::Request &req, ae_powerboard_control::GetEscDeviceInfo::Response &res);
         bool CallbackEscErrorLog(ae_powerboard_control::GetEscErrorLog::Request &req, ae_powerboard_control::GetEscErrorLog::Response &res);
@@ -115,17 +266,50 @@ class Control
         bool CallbackLedCustomColor(ae_powerboard_control::SetLedCustomColor::Request &req, ae_powerboard_control::SetLedCustomColor::Response &res);
         bool CallbackLedPredefinedEffect(ae_powerboard_control::SetLedPredefinedEffect::Request &req, ae_powerboard_control::SetLedPredefinedEffect::Response &res);
         bool CallbackLedCustomEffect(ae_powerboard_control::SetLedCustomEffect::Request &req, ae_powerboard_control::SetLedCustomEffect::Response &res);
+        bool CallbackLedLayer(ae_powerboard_control::SetLedLayer::Request &req, ae_powerboard_control::SetLedLayer::Response &res);
+        //Callback for topic
+        void CallbackLedStreamFrame(const ae_powerboard_control::LedStreamFrame::ConstPtr &msg);
+        void CallbackLedColorCommand(const ae_powerboard_control::LedColorCommand::ConstPtr &msg);
+        void CallbackLedCustomColorCommand(const ae_powerboard_control::LedCustomColorCommand::ConstPtr &msg);
+        void CallbackLedPredefinedEffectCommand(const ae_powerboard_control::LedPredefinedEffectCommand::ConstPtr &msg);
+        void CallbackLedCustomEffectCommand(const ae_powerboard_control::LedCustomEffectCommand::ConstPtr &msg);
         //Callback for timer
         void CallbackMainTimer(const ros::TimerEvent &event);
         void CallbackStateTimer(const ros::TimerEvent &event);
+        void CallbackStatsTimer(const ros::TimerEvent &event);
+        void CallbackTelemetryTimer(const ros::TimerEvent &event);
+        void CallbackPowerboardStateTimer(const ros::TimerEvent &event);
         //Led effect
-        void HandleNoEffect(uint64_t ticks);
-        void HandleEffect_1(uint64_t ticks);
+        uint8_t CommitLedFrame(const LedFrame &frame);
+        bool CheckLedCount(const char *request, size_t count);
+        uint8_t CommitLayer(PowerboardBackend &board, uint8_t layer, const LedFrame &frame, uint8_t blend);
+        void UpdateAutoDim();
+        void UpdateLedStatus();
+        uint8_t DrainLedMailbox(PowerboardBackend &board);
+        //color frames from service request or topic command, return true when command is refused
+        template<class T>
+        bool BuildLedColorFrame(const char *request, const T &command, LedFrame &frame);
+        template<class T>
+        bool BuildLedCustomColorFrame(const char *request, const T &command, LedFrame &frame);
+        //discarded is ticket dropped from mailbox when flush could not be posted, otherwise 0
+        uint64_t PutLedCommand(LedFrame &frame, uint64_t &discarded);
+        //topic command gets its result on status topic, service waits for ticket
+        void PostLedCommand(LedFrame &frame, uint8_t command, uint32_t id);
+        void ReportLedCommands(uint64_t ticket, uint8_t status);
+        void PublishLedCommandStatus(uint8_t command, uint32_t id, bool success, bool coalesced);
+        uint8_t FlushLedCommand(PowerboardBackend &board);
     
     public:
         // constructor
-        Control(const ros::NodeHandle &nh, std::string i2c_address);
+        //topics and services are relative to nh, params are read from private_nh
+        Control(const ros::NodeHandle &nh, const ros::NodeHandle &private_nh, std::string i2c_address, std::string name = "");
         ~Control();
+
+        //boards from ~boards param, one board on default_port when param is missing
+        static std::vector<ControlBoard> ReadBoards(const ros::NodeHandle &private_nh, const std::string &default_port);
+        //topics under ae_powerboard_control[/name] in namespace of nh
+        static ros::NodeHandle BoardNodeHandle(const ros::NodeHandle &nh, const ControlBoard &board);
+        static ros::NodeHandle BoardPrivateNodeHandle(const ros::NodeHandle &private_nh, const ControlBoard &board);
 };
 
 #endif //CONTROL_NODE_HPP
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef CONTROL_NODELET_HPP
+#define CONTROL_NODELET_HPP
+
+#include <memory>
+#include <vector>
+
+#include "nodelet/nodelet.h"
+
+#include "control_node.hpp"
+
+/*
+*  Control loaded into nodelet manager. Topics between nodelets of one manager are passed as shared
+*  pointers without serialization. Callbacks run on multi-threaded queue of the manager, boards are
+*  taken from boards param or I2C port from i2c_port param.
+*/
+class ControlNodelet : public nodelet::Nodelet
+{
+    private:
+        //  ******* properties ********
+        std::vector<std::unique_ptr<Control>> controls_;
+
+        //  ******* methods *******
+        virtual void onInit();
+};
+
+#endif //CONTROL_NODELET_HPP
@@ -0,0 +1,132 @@
+#ifndef FLIGHT_RECORDER_HPP
+#define FLIGHT_RECORDER_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#define FLIGHT_RECORDER_MAGIC       "AEPBFR01"
+#define FLIGHT_RECORDER_VERSION     1
+#define FLIGHT_RECORDER_RECORD_SIZE 64
+
+enum Flight_Record_Type
+{
+    FLIGHT_RECORD_SESSION = 1,
+    FLIGHT_RECORD_ESC_ERROR_LOG = 2,
+    FLIGHT_RECORD_ESC_DATA_LOG = 3,
+    FLIGHT_RECORD_BOARD_STATUS = 4,
+    FLIGHT_RECORD_LED_COMMAND = 5,
+};
+
+enum Flight_Led_Command
+{
+    FLIGHT_LED_COLOR = 1,
+    FLIGHT_LED_CUSTOM_COLOR = 2,
+    FLIGHT_LED_CUSTOM_EFFECT = 3,
+    FLIGHT_LED_PREDEFINED_EFFECT = 4,
+};
+
+struct FlightEscErrorLog
+{
+    uint32_t last_error;
+    uint32_t last_warning;
+    uint32_t previous_error;
+    uint32_t previous_warning;
+    uint32_t all_error;
+    uint32_t all_warning;
+};
+
+struct FlightEscDataLog
+{
+    float motor_max_is;
+    float motor_avg_is;
+    int16_t motor_max_temp;
+    int16_t esc_max_temp;
+};
+
+struct FlightLedCommand
+{
+    uint8_t command;
+    uint8_t mask;
+    uint8_t effect_type;
+    uint8_t reserved;
+    uint16_t count[5];
+    //first color of fl, fr, rl, rr
+    uint8_t color[4][3];
+};
+
+/*
+*  Fixed size record. Sequence is 0 while record is written and index + 1 once it is complete,
+*  so record torn by crash is skipped by decoder.
+*/
+struct FlightRecord
+{
+    uint64_t sequence;
+    int64_t stamp_ns;
+    uint8_t type;
+    uint8_t esc_number;
+    uint8_t status;
+    uint8_t reserved;
+    union
+    {
+        FlightEscErrorLog error_log;
+        FlightEscDataLog data_log;
+        FlightLedCommand led;
+        uint8_t raw[44];
+    } payload;
+};
+
+struct FlightRecorderHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t head;
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(FlightRecord) == FLIGHT_RECORDER_RECORD_SIZE, "FlightRecord layout changed");
+static_assert(sizeof(FlightRecorderHeader) == FLIGHT_RECORDER_RECORD_SIZE, "FlightRecorderHeader layout changed");
+
+/*
+*  Ring buffer of FlightRecord in memory-mapped file. Writes are plain stores into shared mapping,
+*  so data survives crash of the process and Flush() makes it survive power off.
+*  Open recorders are registered process-wide, FlushAll() covers recorders of every board.
+*/
+class FlightRecorder
+{
+    private:
+        //  ******* properties ********
+        int fd_;
+        uint8_t *map_;
+        size_t map_size_;
+        FlightRecorderHeader *header_;
+        FlightRecord *records_;
+        uint64_t capacity_;
+        std::atomic<uint64_t> head_;
+
+    public:
+        //  ******* methods *******
+        FlightRecorder();
+        ~FlightRecorder();
+
+        //returns true on error, existing file with same layout is continued
+        bool Open(const std::string &path, uint64_t capacity);
+        void Close();
+        bool IsOpen() const;
+        //write mapping to disk, blocks until done
+        void Flush();
+        //Flush() of every open recorder in process, e.g. before power off
+        static void FlushAll();
+
+        //no allocation, safe from any thread
+        void Record(FlightRecord &record);
+        //records only when content differs from last, last is updated
+        void RecordChange(FlightRecord &record, FlightRecord &last);
+
+        //zeroed record of given type
+        static FlightRecord Make(uint8_t type, int64_t stamp_ns);
+};
+
+#endif //FLIGHT_RECORDER_HPP
@@ -0,0 +1,60 @@
+#ifndef LED_COLOR_PIPELINE_HPP
+#define LED_COLOR_PIPELINE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pb6s40a_control.h"
+
+//scale of current cap in 1/256, LED_COLOR_SCALE_ONE keeps colors
+#define LED_COLOR_SCALE_ONE     256
+
+/*
+*  Parameters of color correction. Current is estimated linearly from color values,
+*  zero current_budget_ma disables the cap.
+*/
+struct LedColorConfig
+{
+    double brightness;
+    double gamma;
+    double balance[3];
+    double current_per_color_ma;
+    double current_budget_ma;
+
+    LedColorConfig();
+};
+
+/*
+*  Color correction of LED buffers. Gamma, white balance and brightness are folded into lookup table
+*  of every color component, which is rebuilt only when configuration changes. Buffers are processed
+*  as flat byte arrays in single pass loops.
+*/
+class LedColorPipeline
+{
+    private:
+        //  ******* properties ********
+        LedColorConfig config_;
+        uint8_t lut_[3][256];
+        bool identity_;
+
+        //  ******* methods *******
+        void BuildLut();
+
+    public:
+        //  ******* methods *******
+        LedColorPipeline();
+
+        void Configure(const LedColorConfig &config);
+        void SetBrightness(double brightness);
+        double Brightness() const;
+
+        //corrected colors are written to output, returns sum of all output components (load)
+        uint32_t Apply(const COLOR *input, COLOR *output, size_t count) const;
+        //scale which keeps load of all channels in current budget
+        uint16_t CapScale(uint64_t load) const;
+        double Current(uint64_t load) const;
+
+        static void Scale(COLOR *colors, size_t count, uint16_t scale);
+};
+
+#endif //LED_COLOR_PIPELINE_HPP
@@ -0,0 +1,72 @@
+#ifndef LED_COMPOSITOR_HPP
+#define LED_COMPOSITOR_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "led_output.hpp"
+
+#define LED_LAYER_COUNT     4
+
+//composed from bottom to top
+enum Led_Layer
+{
+    LED_LAYER_BASE = 0,
+    LED_LAYER_STATUS = 1,
+    LED_LAYER_ESC_STATUS = 2,   //ESC health from LedStatus, not available to clients
+    LED_LAYER_SAFETY = 3,
+};
+
+enum Led_Blend
+{
+    LED_BLEND_REPLACE = 0,
+    LED_BLEND_ADD = 1,
+    LED_BLEND_MAX = 2,
+    LED_BLEND_MULTIPLY = 3,
+    LED_BLEND_COUNT = 4,
+};
+
+/*
+*  Ordered LED layers (base, status, esc status, safety) blended into one frame. Every layer covers its own channels
+*  with its blend mode, changes of layer re-compose only channels it touched.
+*  Must be used only from bus thread.
+*/
+class LedCompositor
+{
+    private:
+        struct Layer
+        {
+            std::vector<COLOR> colors[LED_CHANNEL_COUNT];
+            uint8_t mask;
+            uint8_t blend;
+            std::string owner;
+        };
+
+        //  ******* properties ********
+        Layer layers_[LED_LAYER_COUNT];
+        LedFrame output_;
+        uint16_t composed_count_[LED_CHANNEL_COUNT];
+
+    public:
+        //  ******* methods *******
+        LedCompositor();
+
+        //buffers for count leds per channel, before first use
+        void Reserve(uint16_t count);
+        //returns true when layer is owned by another client or owner is empty
+        bool Claim(uint8_t layer, const std::string &owner);
+        void Release(uint8_t layer);
+        //returns channels which have to be composed again
+        uint8_t Set(uint8_t layer, const LedFrame &frame, uint8_t blend);
+        uint8_t Clear(uint8_t layer, uint8_t mask);
+        //channels covered by any layer
+        uint8_t Mask() const;
+        //frame with composed channels of mask, valid until next call
+        const LedFrame &Compose(uint8_t mask, bool update_count);
+
+        static void Blend(uint8_t blend, const std::vector<COLOR> &layer, std::vector<COLOR> &result);
+        static const char *LayerName(uint8_t layer);
+};
+
+#endif //LED_COMPOSITOR_HPP
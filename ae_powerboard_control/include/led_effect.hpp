@@ -0,0 +1,142 @@
+#ifndef LED_EFFECT_HPP
+#define LED_EFFECT_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+
+#include "ros/ros.h"
+
+#include "led_output.hpp"
+
+#define LED_EFFECT_DEFAULT_LEDS 8
+#define LED_EFFECT_MAX_LEDS     256
+#define LED_EFFECT_MAX_TICKS    (1 << 20)
+#define LED_EFFECT_MAX_COLORS   (1 << 20)
+
+/*
+*  Keyframe description of effect. Every track drives its channels through sequence of steps,
+*  tracks run in parallel and loop independently.
+*/
+struct LedEffectStep
+{
+    uint32_t ticks;
+    std::vector<COLOR> pattern;     //missing LEDs are off
+};
+
+struct LedEffectTrack
+{
+    uint8_t mask;
+    std::vector<LedEffectStep> steps;
+};
+
+struct LedEffectDescription
+{
+    uint8_t id;
+    std::string name;
+    uint16_t leds_count;
+    bool loop;
+    std::vector<LedEffectTrack> tracks;
+};
+
+/*
+*  Effect compiled into flat frame table. Frame f of channel ch starts at Channel(f, ch),
+*  changed holds channels which differ from previous frame. Frame f is shown from tick starts[f]
+*  of every loop of length ticks.
+*/
+struct LedEffect
+{
+    uint8_t id;
+    std::string name;
+    uint8_t mask;
+    uint16_t leds_count;
+    bool loop;
+    double tick_period_s;
+    uint32_t length;
+    std::vector<COLOR> colors;
+    std::vector<uint32_t> durations;
+    std::vector<uint32_t> starts;
+    std::vector<uint8_t> changed;
+
+    size_t FrameCount() const;
+    const COLOR *Channel(size_t frame, uint8_t channel) const;
+    //frame shown at tick of loop, tick must be lower than length
+    size_t FrameAt(uint32_t tick) const;
+
+    //returns true on error
+    static bool Compile(const LedEffectDescription &description, LedEffect &effect, std::string &error);
+};
+
+/*
+*  Compiled effects by id. Built-in effects can be replaced or extended from led_effects param.
+*/
+class LedEffectLibrary
+{
+    private:
+        //  ******* properties ********
+        std::map<uint8_t, LedEffect> effects_;
+
+        //  ******* methods *******
+        void Add(const LedEffectDescription &description, double tick_period_s, uint16_t capacity);
+        static bool ReadDescription(XmlRpc::XmlRpcValue &item, double tick_period_s, LedEffectDescription &description, std::string &error);
+
+    public:
+        //  ******* methods *******
+        //built-in effects followed by led_effects param, durations are rounded to ticks,
+        //effects with more leds than capacity of channel are ignored
+        void Load(const ros::NodeHandle &nh, double tick_period_s, uint16_t capacity);
+        const LedEffect *Find(uint8_t id) const;
+
+        static std::vector<LedEffectDescription> DefaultDescriptions();
+};
+
+/*
+*  Playback state of one effect. Frame is computed from time elapsed since start, so late tick
+*  jumps to the frame which should be shown instead of shifting rest of the effect.
+*  Effects started at same time are in phase, also on different vehicles with synchronized clocks.
+*  Used only from one thread, except ReadStats and ReadWindowPhaseError.
+*/
+class LedEffectPlayer
+{
+    public:
+        struct Stats
+        {
+            uint64_t frames;
+            uint64_t skipped_frames;
+        };
+
+    private:
+        //  ******* properties ********
+        const LedEffect *effect_;
+        ros::Time start_;
+        //frame counted from start over all loops
+        uint64_t position_;
+        bool started_;
+        //statistics
+        std::atomic<uint64_t> frames_;
+        std::atomic<uint64_t> skipped_frames_;
+        std::atomic<uint64_t> window_frames_;
+        std::atomic<uint64_t> window_phase_error_ns_;
+        std::atomic<uint64_t> window_max_phase_error_ns_;
+
+        //  ******* methods *******
+        void FillFrame(size_t frame, uint8_t mask, LedFrame &frame_out) const;
+        void CountPhaseError(double phase_error_s);
+
+    public:
+        //  ******* methods *******
+        LedEffectPlayer();
+
+        //NULL stops playback, start can be in past or future
+        void Start(const LedEffect *effect, const ros::Time &start);
+        bool IsRunning() const;
+        //returns true when frame has to be written, frame then holds only channels of this frame
+        bool Tick(const ros::Time &now, LedFrame &frame);
+        Stats ReadStats() const;
+        //mean and max delay of written frames behind their schedule since last call
+        void ReadWindowPhaseError(double &mean_s, double &max_s);
+};
+
+#endif //LED_EFFECT_HPP
@@ -0,0 +1,59 @@
+#ifndef LED_LATENCY_BENCHMARK_HPP
+#define LED_LATENCY_BENCHMARK_HPP
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ros/ros.h"
+
+#include "ae_powerboard_control/LedColorCommand.h"
+#include "ae_powerboard_control/LedCommandStatus.h"
+#include "ae_powerboard_control/EscDataLogs.h"
+
+/*
+*  Latency of topics between control and its client. Run as separate node it measures loopback TCP
+*  with serialization, run as nodelet in manager of control it measures shared pointers.
+*  Led commands are published at ~rate Hz until ~count were sent, round trip is taken from publish
+*  until status with same id. Delivery is taken from stamp of status (set just before publish) until
+*  it is received, telemetry age from stamp of esc/data_log until it is received.
+*  Report is logged once, control topics are under ~control_ns relative to namespace of nh.
+*/
+class LedLatencyBenchmark
+{
+    private:
+        //  ******* properties ********
+        ros::NodeHandle nh_;
+        ros::NodeHandle private_nh_;
+        ros::Publisher led_color_cmd_pub_;
+        ros::Subscriber led_command_status_sub_;
+        ros::Subscriber esc_data_log_sub_;
+        ros::Timer command_timer_;
+        ros::Timer report_timer_;
+        uint32_t count_;
+        //callbacks of nodelet run concurrently
+        std::mutex mutex_;
+        uint32_t sent_;
+        std::map<uint32_t, ros::WallTime> pending_;
+        std::vector<double> round_trip_ms_;
+        std::vector<double> status_delivery_ms_;
+        std::vector<double> telemetry_delivery_ms_;
+        uint32_t failed_;
+        uint32_t coalesced_;
+        bool reported_;
+
+        //  ******* methods *******
+        void CallbackCommandTimer(const ros::TimerEvent &event);
+        void CallbackReportTimer(const ros::TimerEvent &event);
+        void CallbackLedCommandStatus(const ae_powerboard_control::LedCommandStatus::ConstPtr &msg);
+        void CallbackEscDataLog(const ae_powerboard_control::EscDataLogs::ConstPtr &msg);
+        void Report();
+        static void ReportLatency(const char *name, std::vector<double> &latencies_ms);
+
+    public:
+        //  ******* methods *******
+        LedLatencyBenchmark(const ros::NodeHandle &nh, const ros::NodeHandle &private_nh);
+};
+
+#endif //LED_LATENCY_BENCHMARK_HPP
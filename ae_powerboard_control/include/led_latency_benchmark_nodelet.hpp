@@ -0,0 +1,23 @@
+#ifndef LED_LATENCY_BENCHMARK_NODELET_HPP
+#define LED_LATENCY_BENCHMARK_NODELET_HPP
+
+#include <memory>
+
+#include "nodelet/nodelet.h"
+
+#include "led_latency_benchmark.hpp"
+
+/*
+*  LedLatencyBenchmark loaded into manager of ControlNodelet, topics are passed as shared pointers.
+*/
+class LedLatencyBenchmarkNodelet : public nodelet::Nodelet
+{
+    private:
+        //  ******* properties ********
+        std::unique_ptr<LedLatencyBenchmark> benchmark_;
+
+        //  ******* methods *******
+        virtual void onInit();
+};
+
+#endif //LED_LATENCY_BENCHMARK_NODELET_HPP
@@ -0,0 +1,78 @@
+#ifndef LED_MAILBOX_HPP
+#define LED_MAILBOX_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "led_output.hpp"
+
+#define LED_MAILBOX_HISTORY         8
+#define LED_MAILBOX_STATUS_TIMEOUT  0xff
+
+/*
+*  Single slot for LED frames. Newer frame replaces frame which was not taken yet (channels missing
+*  in newer frame are kept from replaced one), so consumer always gets the latest state and nothing
+*  is queued behind slow bus. Every frame gets ticket, submitter can wait until frame with its ticket
+*  or newer frame which replaced it is applied.
+*/
+class LedMailbox
+{
+    public:
+        struct Stats
+        {
+            uint64_t received;
+            uint64_t applied;
+            uint64_t dropped;
+        };
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Completion
+        {
+            uint64_t ticket;
+            uint8_t status;
+        };
+
+        //  ******* properties ********
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        LedFrame slot_;
+        bool full_;
+        uint64_t next_ticket_;
+        uint64_t slot_ticket_;
+        Clock::time_point last_take_;
+        //recently applied tickets, oldest is overwritten
+        Completion completed_[LED_MAILBOX_HISTORY];
+        uint64_t completed_count_;
+        std::atomic<uint64_t> received_;
+        std::atomic<uint64_t> applied_;
+        std::atomic<uint64_t> dropped_;
+
+    public:
+        //  ******* methods *******
+        LedMailbox();
+
+        //slot buffers of count leds, frames swapped through mailbox keep their capacity
+        void Reserve(uint16_t count);
+        //frame is swapped into slot, returns true when slot was empty and consumer has to be woken
+        bool Put(LedFrame &frame);
+        bool Put(LedFrame &frame, uint64_t &ticket);
+        //swaps latest frame into frame, returns false when slot is empty
+        bool Take(LedFrame &frame);
+        bool Take(LedFrame &frame, uint64_t &ticket);
+        //taken frame was written with status
+        void Complete(uint64_t ticket, uint8_t status);
+        //consumer could not be woken, frame in slot is dropped and completed with status so next put wakes again
+        bool Discard(uint8_t status, uint64_t &ticket);
+        //waits until ticket is applied, returns its status or LED_MAILBOX_STATUS_TIMEOUT
+        uint8_t Wait(uint64_t ticket, double timeout_s, bool &coalesced);
+        //time left until period_s since last take passes
+        double TakeDelay(double period_s);
+        Stats ReadStats() const;
+};
+
+#endif //LED_MAILBOX_HPP
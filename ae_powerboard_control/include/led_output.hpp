@@ -0,0 +1,145 @@
+#ifndef LED_OUTPUT_HPP
+#define LED_OUTPUT_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+
+#include "powerboard_backend.hpp"
+#include "led_color_pipeline.hpp"
+
+#define LED_CHANNEL_COUNT   5
+
+enum Led_Channel
+{
+    LED_CHANNEL_FL = 0,
+    LED_CHANNEL_FR = 1,
+    LED_CHANNEL_RL = 2,
+    LED_CHANNEL_RR = 3,
+    LED_CHANNEL_AD = 4,
+};
+
+#define LED_CHANNEL_MASK(channel)   (1 << (channel))
+#define LED_CHANNEL_MASK_ARMS       0x0f
+#define LED_CHANNEL_MASK_ALL        0x1f
+
+/*
+*  Complete LED frame - colors of every written channel, optionally with new LED counts.
+*  Channels not present in mask keep their current content on the board.
+*/
+struct LedFrame
+{
+    std::vector<COLOR> colors[LED_CHANNEL_COUNT];
+    uint8_t mask;
+    bool update_count;
+
+    LedFrame();
+    //channel buffers of count leds are written without allocation
+    void Reserve(uint16_t count);
+    void SetChannel(uint8_t channel, const COLOR *buffer, uint16_t count);
+    void FillChannel(uint8_t channel, const COLOR &color, uint16_t count);
+};
+
+/*
+*  Parameters of effect rendered by board itself.
+*/
+struct LedPredefinedEffect
+{
+    COLOR front_left;
+    COLOR front_right;
+    COLOR rear_left;
+    COLOR rear_right;
+    uint8_t on_led_cycles;
+    uint8_t off_led_cycles;
+    uint8_t effect_type;
+    bool set_default;
+};
+
+/*
+*  LED output stage. Commits whole frame inside one bus command: counts, channel buffers and update.
+*  Channels are color corrected from kept source colors, so brightness or current cap changes
+*  re-render them without new frame. Keeps shadow copy of every channel sent to the board
+*  and writes only channels which differ.
+*  LED configuration (counts, predefined effect) is cached too and written only when it changes.
+*  Must be used only from bus thread, except ReadStats.
+*/
+class LedOutput
+{
+    public:
+        struct Stats
+        {
+            uint64_t frames;
+            uint64_t sent_bytes;
+            uint64_t skipped_bytes;
+            uint64_t sent_channels;
+            uint64_t skipped_channels;
+            uint64_t skipped_updates;
+            uint64_t skipped_config_writes;
+            uint64_t limited_frames;
+            double estimated_current_ma;
+        };
+
+    private:
+        //  ******* properties ********
+        LEDS_COUNT leds_count_;
+        bool leds_count_valid_;
+        //shadow of last committed channel buffers
+        std::vector<COLOR> shadow_[LED_CHANNEL_COUNT];
+        uint8_t shadow_valid_;
+        //colors before correction, rendered output and its load
+        LedColorPipeline color_;
+        std::vector<COLOR> source_[LED_CHANNEL_COUNT];
+        uint8_t source_valid_;
+        std::vector<COLOR> output_[LED_CHANNEL_COUNT];
+        uint32_t load_[LED_CHANNEL_COUNT];
+        uint16_t scale_;
+        //cached predefined effect configuration
+        LedPredefinedEffect predefined_effect_;
+        bool predefined_effect_valid_;
+        bool predefined_enabled_;
+        bool predefined_enabled_valid_;
+        //statistics
+        std::atomic<uint64_t> frames_;
+        std::atomic<uint64_t> sent_bytes_;
+        std::atomic<uint64_t> skipped_bytes_;
+        std::atomic<uint64_t> sent_channels_;
+        std::atomic<uint64_t> skipped_channels_;
+        std::atomic<uint64_t> skipped_updates_;
+        std::atomic<uint64_t> skipped_config_writes_;
+        std::atomic<uint64_t> limited_frames_;
+        std::atomic<uint64_t> shown_load_;
+
+        //  ******* methods *******
+        uint8_t ReadCount(PowerboardBackend &board);
+        uint8_t WriteCount(PowerboardBackend &board, const LEDS_COUNT &leds_count, bool &written);
+        uint8_t Render(PowerboardBackend &board, uint8_t mask, bool &changed);
+        uint8_t Send(PowerboardBackend &board, uint8_t channel, bool &changed);
+
+    public:
+        //  ******* methods *******
+        LedOutput();
+
+        //before first commit
+        void ConfigureColor(const LedColorConfig &config);
+        void Reserve(uint16_t count);
+        uint8_t SetBrightness(PowerboardBackend &board, double brightness);
+        uint8_t Commit(PowerboardBackend &board, const LedFrame &frame);
+        uint8_t CommitCount(PowerboardBackend &board, uint8_t mask, uint16_t count);
+        uint8_t SwitchPredefinedEffect(PowerboardBackend &board, bool enable);
+        uint8_t CommitPredefinedEffect(PowerboardBackend &board, const LedPredefinedEffect &effect, uint16_t count);
+        //board content is unknown (e.g. predefined effect is running)
+        void Invalidate();
+        //channels rendered from committed frames
+        uint8_t ShownMask() const;
+        //board is known to render predefined effect instead of buffers
+        bool PredefinedEnabled() const;
+        Stats ReadStats() const;
+
+        static uint8_t ChannelBuffer(uint8_t channel);
+        static uint16_t GetCount(const LEDS_COUNT &leds_count, uint8_t channel);
+        static void SetCount(LEDS_COUNT &leds_count, uint8_t channel, uint16_t count);
+        static bool SameColor(const COLOR &a, const COLOR &b);
+        static bool SamePredefinedEffect(const LedPredefinedEffect &a, const LedPredefinedEffect &b);
+};
+
+#endif //LED_OUTPUT_HPP
@@ -0,0 +1,78 @@
+#ifndef LED_STATUS_HPP
+#define LED_STATUS_HPP
+
+#include <stdint.h>
+
+#include "ros/ros.h"
+
+#include "led_output.hpp"
+#include "led_effect.hpp"
+#include "telemetry_store.hpp"
+
+enum Led_Status
+{
+    LED_STATUS_OK = 0,
+    LED_STATUS_WARNING = 1,
+    LED_STATUS_CRITICAL = 2,
+    LED_STATUS_BOARD = 3,
+    LED_STATUS_COUNT = 4,
+};
+
+/*
+*  Thresholds and colors of ESC health shown on arms. Temperatures are in deg C,
+*  level falls back only when temperature drops hysteresis below its threshold.
+*/
+struct LedStatusConfig
+{
+    bool enable;
+    uint16_t leds_count;
+    double esc_temp_warning;
+    double esc_temp_critical;
+    double motor_temp_warning;
+    double motor_temp_critical;
+    double hysteresis;
+    uint32_t warning_mask;
+    uint32_t error_mask;
+    COLOR colors[LED_STATUS_COUNT];
+    //without ok color arm is given back to layers below
+    bool show_ok;
+
+    LedStatusConfig();
+};
+
+/*
+*  ESC health of esc1..esc4 rendered onto fl, fr, rl, rr arm. Level of every arm is computed from telemetry
+*  snapshot (temperatures, last error and warning bits, board status) and arm is rendered only when it changes.
+*  Must be used only from one thread.
+*/
+class LedStatus
+{
+    private:
+        //  ******* properties ********
+        LedStatusConfig config_;
+        uint8_t esc_temp_levels_[TELEMETRY_ESC_COUNT];
+        uint8_t motor_temp_levels_[TELEMETRY_ESC_COUNT];
+        uint8_t levels_[TELEMETRY_ESC_COUNT];
+        bool rendered_;
+
+        //  ******* methods *******
+        uint8_t TempLevel(double temp, double warning, double critical, uint8_t current) const;
+        static bool ReadColor(const ros::NodeHandle &nh, const std::string &name, COLOR &color);
+
+    public:
+        //  ******* methods *******
+        LedStatus();
+
+        //leds_count is clamped to capacity of channel
+        void Load(const ros::NodeHandle &nh, uint16_t capacity);
+        bool IsEnabled() const;
+        //returns mask of arms whose level changed
+        uint8_t Update(const TelemetrySnapshot &telemetry);
+        //arms of mask which have color are written to frame, others are returned in clear
+        void Render(uint8_t mask, LedFrame &frame, uint8_t &clear) const;
+        uint8_t Level(uint8_t esc_index) const;
+
+        static const char *LevelName(uint8_t level);
+};
+
+#endif //LED_STATUS_HPP
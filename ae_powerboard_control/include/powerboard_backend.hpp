@@ -0,0 +1,81 @@
+#ifndef POWERBOARD_BACKEND_HPP
+#define POWERBOARD_BACKEND_HPP
+
+#include <stdint.h>
+#include <string>
+
+#include "i2c_driver.h"
+#include "pb6s40a_control.h"
+
+/*
+*  Bus backend - register level access to the power board.
+*  Mirrors calls of Pb6s40aDroneControl and Pb6s40aLedsControl, every call returns driver status (0 means success).
+*/
+class PowerboardBackend
+{
+    public:
+        virtual ~PowerboardBackend() {}
+
+        //open port, returns true on error
+        virtual bool Open(const std::string &port) = 0;
+        virtual void Close() = 0;
+        //backend does not drive real hardware
+        virtual bool IsSimulated() const = 0;
+
+        //drone control
+        virtual uint8_t PowerBoardStatusGet(uint8_t *status) = 0;
+        virtual uint8_t PowerBoardInfoGet(POWER_BOARD_INFO *info) = 0;
+        virtual uint8_t DroneTurnOff() = 0;
+        virtual uint8_t EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc) = 0;
+        virtual uint8_t EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc) = 0;
+        virtual uint8_t EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc) = 0;
+        virtual uint8_t EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc) = 0;
+
+        //leds control
+        virtual uint8_t LedsSwitchPredefinedEffect(bool enable) = 0;
+        virtual uint8_t LedsGetLedsCount(LEDS_COUNT &leds_count) = 0;
+        virtual uint8_t LedsSetLedsCount(LEDS_COUNT leds_count) = 0;
+        virtual uint8_t LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count) = 0;
+        virtual uint8_t LedsUpdate() = 0;
+        virtual uint8_t LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+            uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default) = 0;
+};
+
+/*
+*  Real DroneCore.Power board on I2C bus.
+*/
+class HardwareBackend : public PowerboardBackend
+{
+    private:
+        //  ******* properties ********
+        I2CDriver i2c_driver_;
+        Pb6s40aDroneControl *drone_control_;
+        Pb6s40aLedsControl *led_control_;
+
+    public:
+        //  ******* methods *******
+        HardwareBackend();
+        ~HardwareBackend();
+
+        bool Open(const std::string &port);
+        void Close();
+        bool IsSimulated() const;
+
+        uint8_t PowerBoardStatusGet(uint8_t *status);
+        uint8_t PowerBoardInfoGet(POWER_BOARD_INFO *info);
+        uint8_t DroneTurnOff();
+        uint8_t EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc);
+        uint8_t EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc);
+        uint8_t EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc);
+        uint8_t EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc);
+
+        uint8_t LedsSwitchPredefinedEffect(bool enable);
+        uint8_t LedsGetLedsCount(LEDS_COUNT &leds_count);
+        uint8_t LedsSetLedsCount(LEDS_COUNT leds_count);
+        uint8_t LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count);
+        uint8_t LedsUpdate();
+        uint8_t LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+            uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default);
+};
+
+#endif //POWERBOARD_BACKEND_HPP
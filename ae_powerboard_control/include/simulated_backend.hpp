@@ -0,0 +1,102 @@
+#ifndef SIMULATED_BACKEND_HPP
+#define SIMULATED_BACKEND_HPP
+
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include "ros/ros.h"
+
+#include "powerboard_backend.hpp"
+#include "led_output.hpp"
+
+#define SIMULATED_PORT      "sim"
+#define SIMULATED_ESC_COUNT 4
+
+/*
+*  In-process model of the power board register map, used instead of real I2C bus.
+*  Supports per-transaction latency, error injection, scripted ESC telemetry and scripted shutdown.
+*/
+class SimulatedBackend : public PowerboardBackend
+{
+    public:
+        //  ******* constants ********
+        //ESC telemetry applied when time from open reaches time_s, NAN values are not changed
+        struct EscSample
+        {
+            double time_s;
+            uint8_t esc;
+            float esc_temp;
+            float motor_temp;
+            float is_max;
+            float is_avg;
+            int64_t error;
+            int64_t warning;
+        };
+
+        struct Config
+        {
+            uint32_t transaction_latency_us;    //latency of every call
+            uint32_t byte_latency_us;           //additional latency per transferred payload byte
+            double error_rate;                  //probability of failed call <0, 1>
+            uint32_t seed;
+            double turning_off_s;               //board reports turning off after this time, <= 0 disables
+            std::vector<EscSample> esc_script;  //sorted by time
+        };
+
+        //  ******* methods *******
+        SimulatedBackend(const Config &config);
+
+        static Config ReadConfig(const ros::NodeHandle &nh);
+
+        bool Open(const std::string &port);
+        void Close();
+        bool IsSimulated() const;
+
+        uint8_t PowerBoardStatusGet(uint8_t *status);
+        uint8_t PowerBoardInfoGet(POWER_BOARD_INFO *info);
+        uint8_t DroneTurnOff();
+        uint8_t EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc);
+        uint8_t EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc);
+        uint8_t EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc);
+        uint8_t EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc);
+
+        uint8_t LedsSwitchPredefinedEffect(bool enable);
+        uint8_t LedsGetLedsCount(LEDS_COUNT &leds_count);
+        uint8_t LedsSetLedsCount(LEDS_COUNT leds_count);
+        uint8_t LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count);
+        uint8_t LedsUpdate();
+        uint8_t LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+            uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        //  ******* properties ********
+        Config config_;
+        std::mt19937 random_;
+        std::uniform_real_distribution<double> error_distribution_;
+        Clock::time_point open_time_;
+        size_t script_index_;
+        //board
+        uint8_t program_state_;
+        POWER_BOARD_INFO board_info_;
+        //esc
+        ERROR_WARN_LOG esc_error_log_[SIMULATED_ESC_COUNT];
+        RUN_DATA_Struct esc_data_log_[SIMULATED_ESC_COUNT];
+        ADB_DEVICE_INFO esc_device_info_[SIMULATED_ESC_COUNT];
+        RESISTANCE_STRUCT esc_resistance_[SIMULATED_ESC_COUNT];
+        //leds
+        LEDS_COUNT leds_count_;
+        std::vector<COLOR> leds_pending_[LED_CHANNEL_COUNT];
+        std::vector<COLOR> leds_shown_[LED_CHANNEL_COUNT];
+        bool predefined_enabled_;
+        uint8_t predefined_effect_type_;
+
+        //  ******* methods *******
+        uint8_t Transaction(uint32_t bytes);
+        void RunScript();
+        int EscIndex(uint8_t esc) const;
+};
+
+#endif //SIMULATED_BACKEND_HPP
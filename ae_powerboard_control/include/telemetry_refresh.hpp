@@ -0,0 +1,35 @@
+#ifndef TELEMETRY_REFRESH_HPP
+#define TELEMETRY_REFRESH_HPP
+
+#include <stdint.h>
+#include <functional>
+#include <future>
+#include <mutex>
+
+#include "telemetry_scheduler.hpp"
+
+/*
+*  Joins identical on-demand reads. First caller runs the read, callers arriving while it is
+*  in flight wait for the same result instead of queueing another bus transaction.
+*/
+class TelemetryRefresh
+{
+    public:
+        typedef std::function<bool()> Read;
+
+    private:
+        //  ******* properties ********
+        std::mutex mutex_;
+        std::shared_future<bool> esc_pending_[TELEMETRY_CLASS_COUNT][TELEMETRY_ESC_COUNT];
+        std::shared_future<bool> board_pending_;
+
+        //  ******* methods *******
+        bool Run(std::shared_future<bool> &pending, const Read &read);
+
+    public:
+        //  ******* methods *******
+        bool RunEsc(uint8_t data_class, uint8_t esc_index, const Read &read);
+        bool RunBoard(const Read &read);
+};
+
+#endif //TELEMETRY_REFRESH_HPP
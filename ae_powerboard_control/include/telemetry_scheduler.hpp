@@ -0,0 +1,48 @@
+#ifndef TELEMETRY_SCHEDULER_HPP
+#define TELEMETRY_SCHEDULER_HPP
+
+#include <stdint.h>
+
+#define TELEMETRY_ESC_COUNT 4
+#define TELEMETRY_ESC_MASK_ALL 0x0f
+
+enum Telemetry_Class
+{
+    TELEMETRY_ERROR_LOG = 0,
+    TELEMETRY_DATA_LOG = 1,
+    TELEMETRY_DEVICE_INFO = 2,
+    TELEMETRY_RESISTANCE = 3,
+    TELEMETRY_CLASS_COUNT = 4,
+};
+
+/*
+*  Schedules ESC telemetry reads. Every data class has its own rate (full sweep of all ESCs per second),
+*  ESCs are read round-robin one at a time, so one read never blocks the bus for long.
+*/
+class TelemetryScheduler
+{
+    private:
+        struct ClassState
+        {
+            double esc_period_s;    //period between two single esc reads, 0 disables class
+            double next_s;
+            uint8_t next_esc;
+        };
+
+        //  ******* properties ********
+        ClassState classes_[TELEMETRY_CLASS_COUNT];
+
+    public:
+        //  ******* methods *******
+        TelemetryScheduler();
+
+        //rate of full sweep over all ESCs in Hz, <= 0 disables class
+        void SetRate(uint8_t data_class, double rate_hz, double now_s);
+        double GetRate(uint8_t data_class) const;
+        //most overdue read, returns false when nothing is due
+        bool Next(double now_s, uint8_t &data_class, uint8_t &esc_index);
+
+        static const char *ClassName(uint8_t data_class);
+};
+
+#endif //TELEMETRY_SCHEDULER_HPP
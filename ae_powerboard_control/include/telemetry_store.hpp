@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_STORE_HPP
+#define TELEMETRY_STORE_HPP
+
+#include <stdint.h>
+#include <atomic>
+
+#include "ros/ros.h"
+
+#include "pb6s40a_control.h"
+#include "telemetry_scheduler.hpp"
+
+/*
+*  Consistent copy of everything read from the board. Valid bits and capture time are kept per ESC.
+*/
+struct TelemetrySnapshot
+{
+    // **esc**
+    ERROR_WARN_LOG esc_error_log[TELEMETRY_ESC_COUNT];
+    uint8_t esc_error_log_status;
+    ros::Time esc_error_log_stamp[TELEMETRY_ESC_COUNT];
+    RUN_DATA_Struct esc_data_log[TELEMETRY_ESC_COUNT];
+    uint8_t esc_data_log_status;
+    ros::Time esc_data_log_stamp[TELEMETRY_ESC_COUNT];
+    ADB_DEVICE_INFO esc_device_info[TELEMETRY_ESC_COUNT];
+    uint8_t esc_device_info_status;
+    ros::Time esc_device_info_stamp[TELEMETRY_ESC_COUNT];
+    RESISTANCE_STRUCT esc_resistance[TELEMETRY_ESC_COUNT];
+    uint8_t esc_resistance_status;
+    ros::Time esc_resistance_stamp[TELEMETRY_ESC_COUNT];
+    // **board**
+    POWER_BOARD_INFO board_device_info;
+    bool board_device_info_status;
+    ros::Time board_device_info_stamp;
+    uint8_t power_board_status;
+    ros::Time power_board_status_stamp;
+    //time of last change
+    ros::Time stamp;
+
+    //valid and captured not longer than max_age_s before now
+    bool IsEscFresh(uint8_t data_class, uint8_t esc_index, const ros::Time &now, double max_age_s) const;
+    bool IsBoardFresh(const ros::Time &now, double max_age_s) const;
+};
+
+#define TELEMETRY_STORE_WORDS   ((sizeof(TelemetrySnapshot) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+
+/*
+*  Seqlock publication of TelemetrySnapshot. Single writer (bus thread) never waits,
+*  readers copy the snapshot and retry only when it was changed during the copy.
+*  Published copy is kept in atomic words, so racing copy is not a data race.
+*/
+class TelemetryStore
+{
+    private:
+        //  ******* properties ********
+        std::atomic<uint32_t> sequence_;
+        std::atomic<uint64_t> shared_[TELEMETRY_STORE_WORDS];
+        TelemetrySnapshot working_;
+
+        //  ******* methods *******
+        void StoreShared(const TelemetrySnapshot &snapshot);
+        void LoadShared(TelemetrySnapshot &snapshot) const;
+
+    public:
+        //  ******* methods *******
+        TelemetryStore();
+
+        //writer side, only from bus thread
+        TelemetrySnapshot &Edit();
+        void Publish();
+
+        //reader side, any thread
+        TelemetrySnapshot Read() const;
+};
+
+#endif //TELEMETRY_STORE_HPP
@@ -3,6 +3,10 @@
 
 #include "ros/ros.h"
 
+#include "pb6s40a_control.h"
+
+#define FIXED_POINT_NO_ROUNDING 0xff
+
 class Utils
 {
     public:
@@ -11,6 +15,84 @@ class Utils
             I4Q8 = 0x0408,
         };
 
+        /*
+        *  Signed fixed point number with I integer bits (sign included) and Q fractional bits.
+        *  Format and rounding to DECIMAL_PLACES are resolved at compile time, bits above I + Q are not masked.
+        */
+        template<uint8_t I, uint8_t Q, uint8_t DECIMAL_PLACES = FIXED_POINT_NO_ROUNDING>
+        struct FixedPoint
+        {
+            static_assert(I + Q >= 1 && I + Q <= 32, "FixedPoint supports 1 to 32 bits");
+
+            static constexpr uint32_t SignMask()
+            {
+                return 0x01u << (I + Q - 1);
+            }
+
+            static constexpr float Scale()
+            {
+                return 1.0f / (float)(1ull << Q);
+            }
+
+            //double like pow() of ConvertFixedToFloat, so rounding gives same results
+            static constexpr double Pow10(uint8_t exponent)
+            {
+                return exponent ? 10.0 * Pow10(exponent - 1) : 1.0;
+            }
+
+            static float ToFloat(uint32_t number)
+            {
+                //sign bit is extended over all upper bits, mask is compile time constant
+                int32_t sign_value = (number & SignMask()) ? (int32_t)(number | (~(SignMask() - 1))) : (int32_t)number;
+                float result = (float)sign_value * Scale();
+                if(DECIMAL_PLACES == FIXED_POINT_NO_ROUNDING)
+                {
+                    return result;
+                }
+                result = (float)(result * Pow10(DECIMAL_PLACES));
+                return (float)(roundf(result) / Pow10(DECIMAL_PLACES));
+            }
+
+            static void ToFloat(const uint32_t *numbers, float *results, size_t count)
+            {
+                for(size_t i = 0; i < count; i++)
+                {
+                    results[i] = ToFloat(numbers[i]);
+                }
+            }
+        };
+
+        //ESC motor current, I4Q8 rounded to whole amperes
+        typedef FixedPoint<4, 8, 0> MotorCurrent;
+
+        //ESC data log in physical units
+        struct EscDataValues
+        {
+            float motor_max_is;
+            float motor_avg_is;
+            int16_t motor_max_temp;
+            int16_t esc_max_temp;
+        };
+
+        static EscDataValues ConvertDataLog(const RUN_DATA_Struct &data_log)
+        {
+            EscDataValues values;
+            values.motor_max_is = MotorCurrent::ToFloat(data_log.Is_Motor_Max);
+            values.motor_avg_is = data_log.Is_Motor_Avg * 0.1f;
+            values.motor_max_temp = data_log.Temp_Motor_Max - 50;
+            values.esc_max_temp = data_log.Temp_ESC_Max - 50;
+            return values;
+        }
+
+        template<size_t N>
+        static void ConvertDataLogs(const RUN_DATA_Struct (&data_logs)[N], EscDataValues (&values)[N])
+        {
+            for(size_t i = 0; i < N; i++)
+            {
+                values[i] = ConvertDataLog(data_logs[i]);
+            }
+        }
+
         static float ConvertFixedToFloat(uint32_t number, NumberIq iq, uint8_t decimalPlaces)
         {
             uint8_t q_part = iq & 0xff;
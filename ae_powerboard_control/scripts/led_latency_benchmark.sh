@@ -0,0 +1,55 @@
+#!/bin/sh
+# Control on simulated board with latency benchmark, first as two nodes (loopback TCP), then as two
+# nodelets of one manager (shared pointers). Prints latency report of benchmark and CPU usage of all
+# processes started by the launch while commands are sent. roscore has to be running.
+#
+# usage: led_latency_benchmark.sh [count] [rate]
+
+count=${1:-2000}
+rate=${2:-100}
+ticks=$(getconf CLK_TCK)
+
+# user and system ticks of all children of pid
+cpu_ticks()
+{
+    total=0
+    for pid in $(pgrep -P "$1"); do
+        t=$(awk '{print $14 + $15}' "/proc/$pid/stat" 2>/dev/null)
+        total=$((total + ${t:-0}))
+    done
+    echo "$total"
+}
+
+# waits until line appears in log or launch exits
+wait_for()
+{
+    while ! grep -q "$2" "$1"; do
+        if ! kill -0 "$3" 2>/dev/null; then
+            return 1
+        fi
+        sleep 0.1
+    done
+}
+
+for nodelet in false true; do
+    log=$(mktemp)
+    roslaunch ae_powerboard_control led_latency_benchmark.launch nodelet:=$nodelet count:=$count rate:=$rate > "$log" 2>&1 &
+    launch=$!
+
+    if wait_for "$log" "LED LATENCY - started" $launch; then
+        start_ticks=$(cpu_ticks $launch)
+        start_s=$(date +%s.%N)
+        wait_for "$log" "LED LATENCY - done" $launch
+        end_ticks=$(cpu_ticks $launch)
+        end_s=$(date +%s.%N)
+
+        echo "nodelet:=$nodelet"
+        grep "LED LATENCY - " "$log" | grep -v "started\|done" | sed 's/.*LED LATENCY - /  /'
+        echo "$start_ticks $end_ticks $start_s $end_s $ticks" | awk '{printf "  cpu %.1f %% of one core\n", 100 * ($2 - $1) / $5 / ($4 - $3)}'
+    else
+        echo "nodelet:=$nodelet failed, log in $log"
+    fi
+
+    kill -INT $launch
+    wait $launch
+done
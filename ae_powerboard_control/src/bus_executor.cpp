@@ -0,0 +1,269 @@
+#include "bus_executor.hpp"
+
+const uint8_t BusExecutor::STATUS_NOT_RUNNING;
+
+BusExecutor::BusExecutor()
+    :backend_(NULL),
+     running_(false)
+{
+
+    for(uint8_t i = 0; i < PRIORITY_COUNT; i++)
+    {
+        counters_[i].max_depth = 0;
+        counters_[i].executed = 0;
+        counters_[i].window_executed = 0;
+        counters_[i].window_wait_s = 0.0;
+        counters_[i].max_wait_s = 0.0;
+    }
+}
+
+BusExecutor::~BusExecutor()
+{
+    this->Stop();
+    delete backend_;
+}
+
+void BusExecutor::SetBackend(PowerboardBackend *backend)
+{
+    delete backend_;
+    backend_ = backend ? new MeteredBackend(backend, metrics_) : NULL;
+}
+
+BusMetrics &BusExecutor::Metrics()
+{
+    return metrics_;
+}
+
+bool BusExecutor::IsSimulated() const
+{
+    return backend_ && backend_->IsSimulated();
+}
+
+bool BusExecutor::Open(const std::string &port)
+{
+    if(!backend_)
+    {
+        return true;
+    }
+    return backend_->Open(port);
+}
+
+void BusExecutor::Close()
+{
+    if(backend_)
+    {
+        backend_->Close();
+    }
+}
+
+void BusExecutor::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(running_)
+    {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&BusExecutor::Run, this);
+}
+
+void BusExecutor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    condition_.notify_all();
+
+    if(thread_.joinable())
+    {
+        thread_.join();
+    }
+
+    //release waiting submitters
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(uint8_t i = 0; i < PRIORITY_COUNT; i++)
+    {
+        for(size_t j = 0; j < queues_[i].size(); j++)
+        {
+            if(queues_[i][j].result)
+            {
+                queues_[i][j].result->set_value(STATUS_NOT_RUNNING);
+            }
+        }
+        queues_[i].clear();
+    }
+    deferred_.clear();
+}
+
+uint8_t BusExecutor::Execute(Priority priority, const Command &command)
+{
+    std::shared_ptr<std::promise<uint8_t> > result(new std::promise<uint8_t>());
+    std::future<uint8_t> future = result->get_future();
+
+    this->Submit(priority, command, result);
+
+    return future.get();
+}
+
+uint8_t BusExecutor::Post(Priority priority, const Command &command)
+{
+    return this->Submit(priority, command, std::shared_ptr<std::promise<uint8_t> >());
+}
+
+uint8_t BusExecutor::PostDelayed(Priority priority, double delay_s, const Command &command)
+{
+    if(delay_s <= 0.0)
+    {
+        return this->Post(priority, command);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!running_ || !backend_)
+        {
+            return STATUS_NOT_RUNNING;
+        }
+
+        DeferredTask task;
+        task.priority = priority;
+        task.command = command;
+        Clock::time_point due = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay_s));
+        deferred_.insert(std::make_pair(due, task));
+    }
+    //bus thread has to wait for new due time
+    condition_.notify_one();
+    return 0;
+}
+
+uint8_t BusExecutor::Submit(Priority priority, const Command &command, const std::shared_ptr<std::promise<uint8_t> > &result)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!running_ || !backend_)
+        {
+            if(result)
+            {
+                result->set_value(STATUS_NOT_RUNNING);
+            }
+            return STATUS_NOT_RUNNING;
+        }
+
+        this->Enqueue(priority, command, result);
+    }
+    condition_.notify_one();
+    return 0;
+}
+
+void BusExecutor::Enqueue(Priority priority, const Command &command, const std::shared_ptr<std::promise<uint8_t> > &result)
+{
+    Task task;
+    task.command = command;
+    task.result = result;
+    task.submitted = Clock::now();
+    queues_[priority].push_back(task);
+
+    uint32_t depth = queues_[priority].size();
+    if(depth > counters_[priority].max_depth)
+    {
+        counters_[priority].max_depth = depth;
+    }
+}
+
+BusExecutor::QueueStats BusExecutor::ReadStats(Priority priority)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    QueueCounters &counters = counters_[priority];
+
+    QueueStats stats;
+    stats.depth = queues_[priority].size();
+    stats.max_depth = counters.max_depth;
+    stats.executed = counters.executed;
+    stats.avg_wait_s = counters.window_executed ? counters.window_wait_s / counters.window_executed : 0.0;
+    stats.max_wait_s = counters.max_wait_s;
+
+    counters.max_depth = stats.depth;
+    counters.window_executed = 0;
+    counters.window_wait_s = 0.0;
+    counters.max_wait_s = 0.0;
+
+    return stats;
+}
+
+const char *BusExecutor::PriorityName(Priority priority)
+{
+    switch(priority)
+    {
+        case PRIORITY_STATUS:
+            return "status";
+        case PRIORITY_LED:
+            return "led";
+        case PRIORITY_TELEMETRY:
+            return "telemetry";
+        default:
+            return "unknown";
+    }
+}
+
+void BusExecutor::Run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while(running_)
+    {
+        //delayed commands which are due join their queue
+        Clock::time_point now = Clock::now();
+        while(!deferred_.empty() && deferred_.begin()->first <= now)
+        {
+            DeferredTask &deferred = deferred_.begin()->second;
+            this->Enqueue(deferred.priority, deferred.command, std::shared_ptr<std::promise<uint8_t> >());
+            deferred_.erase(deferred_.begin());
+        }
+
+        //pick the highest priority pending command
+        int priority = -1;
+        for(uint8_t i = 0; i < PRIORITY_COUNT; i++)
+        {
+            if(!queues_[i].empty())
+            {
+                priority = i;
+                break;
+            }
+        }
+
+        if(priority < 0)
+        {
+            if(deferred_.empty())
+            {
+                condition_.wait(lock);
+            }
+            else
+            {
+                condition_.wait_until(lock, deferred_.begin()->first);
+            }
+            continue;
+        }
+
+        Task task = queues_[priority].front();
+        queues_[priority].pop_front();
+
+        double wait_s = std::chrono::duration<double>(Clock::now() - task.submitted).count();
+        QueueCounters &counters = counters_[priority];
+        counters.executed++;
+        counters.window_executed++;
+        counters.window_wait_s += wait_s;
+        if(wait_s > counters.max_wait_s)
+        {
+            counters.max_wait_s = wait_s;
+        }
+
+        //bus access without holding the queue lock
+        lock.unlock();
+        uint8_t status = task.command(*backend_);
+        if(task.result)
+        {
+            task.result->set_value(status);
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,283 @@
+#include "bus_metrics.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+BusMetrics::BusMetrics()
+    :start_(Clock::now()),
+     busy_ns_(0)
+{
+    for(uint8_t i = 0; i < OP_COUNT; i++)
+    {
+        Counters &counters = operations_[i];
+        counters.count = 0;
+        counters.errors = 0;
+        counters.sum_ns = 0;
+        counters.max_ns = 0;
+        counters.window_max_ns = 0;
+        for(uint8_t j = 0; j < BUS_METRICS_BUCKETS; j++)
+        {
+            counters.buckets[j] = 0;
+        }
+    }
+}
+
+void BusMetrics::Record(Operation operation, uint64_t duration_ns, uint8_t status)
+{
+    Counters &counters = operations_[operation];
+
+    //single writer, relaxed increments are enough
+    counters.buckets[Bucket(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+    counters.sum_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+    if(status)
+    {
+        counters.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    if(duration_ns > counters.max_ns.load(std::memory_order_relaxed))
+    {
+        counters.max_ns.store(duration_ns, std::memory_order_relaxed);
+    }
+    //window max is reset by reader
+    uint64_t window_max = counters.window_max_ns.load(std::memory_order_relaxed);
+    while(duration_ns > window_max && !counters.window_max_ns.compare_exchange_weak(window_max, duration_ns, std::memory_order_relaxed))
+    {
+    }
+    busy_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+    counters.count.fetch_add(1, std::memory_order_release);
+}
+
+BusMetrics::Snapshot BusMetrics::Read() const
+{
+    Snapshot snapshot;
+    snapshot.time = Clock::now();
+    snapshot.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+
+    for(uint8_t i = 0; i < OP_COUNT; i++)
+    {
+        const Counters &counters = operations_[i];
+        Histogram &histogram = snapshot.operations[i];
+        histogram.count = counters.count.load(std::memory_order_acquire);
+        histogram.errors = counters.errors.load(std::memory_order_relaxed);
+        histogram.sum_ns = counters.sum_ns.load(std::memory_order_relaxed);
+        for(uint8_t j = 0; j < BUS_METRICS_BUCKETS; j++)
+        {
+            histogram.buckets[j] = counters.buckets[j].load(std::memory_order_relaxed);
+        }
+    }
+
+    return snapshot;
+}
+
+double BusMetrics::ReadMax(Operation operation) const
+{
+    return operations_[operation].max_ns.load(std::memory_order_relaxed) * 1e-9;
+}
+
+double BusMetrics::ReadWindowMax(Operation operation)
+{
+    return operations_[operation].window_max_ns.exchange(0, std::memory_order_relaxed) * 1e-9;
+}
+
+BusMetrics::Summary BusMetrics::Summarize(const Histogram &now, const Histogram &before)
+{
+    uint64_t buckets[BUS_METRICS_BUCKETS];
+    uint64_t count = 0;
+    for(uint8_t j = 0; j < BUS_METRICS_BUCKETS; j++)
+    {
+        buckets[j] = now.buckets[j] - before.buckets[j];
+        count += buckets[j];
+    }
+
+    Summary summary;
+    summary.count = count;
+    summary.errors = now.errors - before.errors;
+    summary.mean_s = count ? (now.sum_ns - before.sum_ns) * 1e-9 / count : 0.0;
+    summary.p50_s = Percentile(buckets, count, 0.50);
+    summary.p99_s = Percentile(buckets, count, 0.99);
+    return summary;
+}
+
+double BusMetrics::BusyFraction(const Snapshot &now, const Snapshot &before)
+{
+    double period_ns = std::chrono::duration<double, std::nano>(now.time - before.time).count();
+    if(period_ns <= 0.0)
+    {
+        return 0.0;
+    }
+    return (now.busy_ns - before.busy_ns) / period_ns;
+}
+
+const char *BusMetrics::OperationName(Operation operation)
+{
+    switch(operation)
+    {
+        case OP_STATUS_GET:
+            return "PowerBoardStatusGet";
+        case OP_BOARD_INFO_GET:
+            return "PowerBoardInfoGet";
+        case OP_TURN_OFF:
+            return "DroneTurnOff";
+        case OP_ESC_ERROR_LOG:
+            return "EscGetErrorLogs";
+        case OP_ESC_DATA_LOG:
+            return "EscGetDataLogs";
+        case OP_ESC_DEVICE_INFO:
+            return "EscGetDeviceInfo";
+        case OP_ESC_RESISTANCE:
+            return "EscGetResistance";
+        case OP_LEDS_SWITCH_PREDEFINED:
+            return "LedsSwitchPredefinedEffect";
+        case OP_LEDS_GET_COUNT:
+            return "LedsGetLedsCount";
+        case OP_LEDS_SET_COUNT:
+            return "LedsSetLedsCount";
+        case OP_LEDS_SEND_BUFFER:
+            return "LedsSendColorBuffer";
+        case OP_LEDS_UPDATE:
+            return "LedsUpdate";
+        case OP_LEDS_SET_PREDEFINED:
+            return "LedsSetPredefinedEffect";
+        default:
+            return "unknown";
+    }
+}
+
+uint8_t BusMetrics::Bucket(uint64_t duration_ns)
+{
+    //bucket 0 is below 1 us, bucket k covers <2^(k-1), 2^k) us
+    uint64_t duration_us = duration_ns / 1000;
+    if(duration_us == 0)
+    {
+        return 0;
+    }
+
+    uint8_t bucket = 64 - __builtin_clzll(duration_us);
+    if(bucket >= BUS_METRICS_BUCKETS)
+    {
+        bucket = BUS_METRICS_BUCKETS - 1;
+    }
+    return bucket;
+}
+
+double BusMetrics::Percentile(const uint64_t *buckets, uint64_t count, double percentile)
+{
+    if(count == 0)
+    {
+        return 0.0;
+    }
+
+    double target = percentile * count;
+    uint64_t cumulative = 0;
+    for(uint8_t j = 0; j < BUS_METRICS_BUCKETS; j++)
+    {
+        if(buckets[j] && cumulative + buckets[j] >= target)
+        {
+            //linear interpolation inside bucket
+            double lower_us = j ? (double)(1ULL << (j - 1)) : 0.0;
+            double upper_us = (double)(1ULL << j);
+            double fraction = (target - cumulative) / buckets[j];
+            return (lower_us + fraction * (upper_us - lower_us)) * 1e-6;
+        }
+        cumulative += buckets[j];
+    }
+    return (double)(1ULL << (BUS_METRICS_BUCKETS - 1)) * 1e-6;
+}
+
+#define METERED_CALL(operation, call)                                                           \
+    Clock::time_point start = Clock::now();                                                     \
+    uint8_t status = (call);                                                                    \
+    uint64_t duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(); \
+    metrics_.Record(BusMetrics::operation, duration_ns, status);                                \
+    return status;
+
+MeteredBackend::MeteredBackend(PowerboardBackend *backend, BusMetrics &metrics)
+    :backend_(backend),
+     metrics_(metrics)
+{
+}
+
+MeteredBackend::~MeteredBackend()
+{
+    delete backend_;
+}
+
+bool MeteredBackend::Open(const std::string &port)
+{
+    return backend_->Open(port);
+}
+
+void MeteredBackend::Close()
+{
+    backend_->Close();
+}
+
+bool MeteredBackend::IsSimulated() const
+{
+    return backend_->IsSimulated();
+}
+
+uint8_t MeteredBackend::PowerBoardStatusGet(uint8_t *status_out)
+{
+    METERED_CALL(OP_STATUS_GET, backend_->PowerBoardStatusGet(status_out));
+}
+
+uint8_t MeteredBackend::PowerBoardInfoGet(POWER_BOARD_INFO *info)
+{
+    METERED_CALL(OP_BOARD_INFO_GET, backend_->PowerBoardInfoGet(info));
+}
+
+uint8_t MeteredBackend::DroneTurnOff()
+{
+    METERED_CALL(OP_TURN_OFF, backend_->DroneTurnOff());
+}
+
+uint8_t MeteredBackend::EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc)
+{
+    METERED_CALL(OP_ESC_ERROR_LOG, backend_->EscGetErrorLogs(log, esc));
+}
+
+uint8_t MeteredBackend::EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc)
+{
+    METERED_CALL(OP_ESC_DATA_LOG, backend_->EscGetDataLogs(log, esc));
+}
+
+uint8_t MeteredBackend::EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc)
+{
+    METERED_CALL(OP_ESC_DEVICE_INFO, backend_->EscGetDeviceInfo(info, esc));
+}
+
+uint8_t MeteredBackend::EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc)
+{
+    METERED_CALL(OP_ESC_RESISTANCE, backend_->EscGetResistance(resistance, esc));
+}
+
+uint8_t MeteredBackend::LedsSwitchPredefinedEffect(bool enable)
+{
+    METERED_CALL(OP_LEDS_SWITCH_PREDEFINED, backend_->LedsSwitchPredefinedEffect(enable));
+}
+
+uint8_t MeteredBackend::LedsGetLedsCount(LEDS_COUNT &leds_count)
+{
+    METERED_CALL(OP_LEDS_GET_COUNT, backend_->LedsGetLedsCount(leds_count));
+}
+
+uint8_t MeteredBackend::LedsSetLedsCount(LEDS_COUNT leds_count)
+{
+    METERED_CALL(OP_LEDS_SET_COUNT, backend_->LedsSetLedsCount(leds_count));
+}
+
+uint8_t MeteredBackend::LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count)
+{
+    METERED_CALL(OP_LEDS_SEND_BUFFER, backend_->LedsSendColorBuffer(buffer, colors, count));
+}
+
+uint8_t MeteredBackend::LedsUpdate()
+{
+    METERED_CALL(OP_LEDS_UPDATE, backend_->LedsUpdate());
+}
+
+uint8_t MeteredBackend::LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+    uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default)
+{
+    METERED_CALL(OP_LEDS_SET_PREDEFINED, backend_->LedsSetPredefinedEffect(front_left, front_right, rear_left, rear_right,
+        on_led_cycles, off_led_cycles, effect_type, set_default));
+}
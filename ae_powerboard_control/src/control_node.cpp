@@ -1,117 +1,745 @@
 #include "control_node.hpp"
 
-Control::Control(const ros::NodeHandle &nh, std::string i2c_address)
+Control::Control(const ros::NodeHandle &nh, const ros::NodeHandle &private_nh, std::string i2c_address, std::string name)
     :nh_(nh),
+     private_nh_(private_nh),
+     name_(name),
      i2c_port_(i2c_address)
 {
     this->Init();
     this->SetupServices();
+    this->SetupPublishers();
+    this->SetupSubscribers();
     this->SetupTimers();
     this->GetAll();
+    this->SetupTelemetry();
 }
 
 Control::~Control()
 {
+    //stop and shutdown wait for callbacks in flight on spinner threads, bus still runs
+    //so callbacks waiting for it finish before members they use are destroyed
+    main_tim_.stop();
+    state_tim_.stop();
+    stats_tim_.stop();
+    telemetry_tim_.stop();
+    powerboard_state_tim_.stop();
+    esc_dev_info_srv_.shutdown();
+    esc_error_log_srv_.shutdown();
+    esc_data_log_srv_.shutdown();
+    esc_resistance_srv_.shutdown();
+    board_dev_info_srv_.shutdown();
+    led_set_custom_color_srv_.shutdown();
+    led_set_color_srv_.shutdown();
+    led_set_custom_effect_srv_.shutdown();
+    led_set_predefined_effect_srv_.shutdown();
+    led_set_layer_srv_.shutdown();
+    board_shutdown_srv_.shutdown();
+    bus_stats_srv_.shutdown();
+    led_stream_sub_.shutdown();
+    led_color_cmd_sub_.shutdown();
+    led_custom_color_cmd_sub_.shutdown();
+    led_predefined_effect_cmd_sub_.shutdown();
+    led_custom_effect_cmd_sub_.shutdown();
+    bus_.Stop();
     this->CloseI2C();
-    drone_control_ = NULL;
-    delete drone_control_;
 }
 
 void Control::Init()
 {
     this->DefaultValues();
+    this->OpenRecorder();
     this->OpenI2C();
+
+    this->AllocateLedBuffers();
+    //named boards share effects of ~led_effects, unless they have own ~<name>/led_effects
+    ros::NodeHandle effects_nh = private_nh_;
+    if(!name_.empty() && !private_nh_.hasParam("led_effects"))
+    {
+        effects_nh = ros::NodeHandle(ros::names::parentNamespace(private_nh_.getNamespace()));
+    }
+    led_effects_.Load(effects_nh, MAIN_TIME_PERIOD_S, led_capacity_);
+    double epoch;
+    private_nh_.param<double>("led_effect_epoch", epoch, 0.0);
+    led_effect_epoch_ = ros::Time(std::max(epoch, 0.0));
+    this->ConfigureLedColor();
+    led_status_.Load(private_nh_, led_capacity_);
+    bus_.Start();
+    bus_metrics_start_ = bus_.Metrics().Read();
+    bus_metrics_last_ = bus_metrics_start_;
 }
 
 void Control::DefaultValues()
 {
-    drone_control_ = new Pb6s40aDroneControl(i2c_driver_, I2C2_MAIN_BOARD_ADDRESS);
-    led_control_ = new Pb6s40aLedsControl(i2c_driver_, I2C2_MAIN_BOARD_ADDRESS);
-    esc_device_info_status_ = 0x00;
     led_effect_run_ = false;
-    power_board_status_ = program_state_run;
+    led_effect_update_ = false;
+    board_status_error_ = false;
+    led_rate_ = 1.0 / MAIN_TIME_PERIOD_S;
+    led_period_s_ = MAIN_TIME_PERIOD_S;
+    board_status_rate_ = 1.0 / STATE_TIME_PERIOD_S;
+    state_rate_ = POWERBOARD_STATE_DEFAULT_RATE;
+    static const double default_rates[TELEMETRY_CLASS_COUNT] = {10.0, 10.0, 0.01, 0.1};
+    for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+    {
+        telemetry_rates_[i] = default_rates[i];
+    }
+    telemetry_rates_changed_ = 0;
+}
+
+void Control::ConfigureLedColor()
+{
+    //brightness, gamma and white balance of all leds, current cap in mA (0 disables it)
+    LedColorConfig config;
+    private_nh_.param<double>("led/brightness", config.brightness, config.brightness);
+    private_nh_.param<double>("led/gamma", config.gamma, config.gamma);
+    private_nh_.param<double>("led/current_per_color_ma", config.current_per_color_ma, config.current_per_color_ma);
+    private_nh_.param<double>("led/current_budget_ma", config.current_budget_ma, config.current_budget_ma);
+    std::vector<double> balance;
+    if(private_nh_.getParam("led/balance", balance))
+    {
+        if(balance.size() == 3)
+        {
+            std::copy(balance.begin(), balance.end(), config.balance);
+        }
+        else
+        {
+            ROS_WARN("LED - led/balance has to be [r, g, b], ignored");
+        }
+    }
+    if(config.gamma <= 0.0)
+    {
+        ROS_WARN("LED - led/gamma has to be positive, 1.0 is used");
+        config.gamma = 1.0;
+    }
+    led_output_.ConfigureColor(config);
+
+    //brightness falls linearly from led/brightness to auto_dim/brightness over ramp_s after start_s (0 disables it)
+    private_nh_.param<double>("led/auto_dim/start_s", led_dim_start_s_, 0.0);
+    private_nh_.param<double>("led/auto_dim/ramp_s", led_dim_ramp_s_, 600.0);
+    private_nh_.param<double>("led/auto_dim/brightness", led_dim_brightness_, 0.3);
+    led_brightness_ = config.brightness;
+    led_brightness_level_ = lround(std::min(std::max(led_brightness_, 0.0), 1.0) * 255);
+    led_start_time_ = ros::Time::now();
+}
+
+void Control::AllocateLedBuffers()
+{
+    //all led buffers are sized once, requests never allocate on bus thread
+    int capacity;
+    private_nh_.param<int>("led/capacity", capacity, LED_DEFAULT_CAPACITY);
+    led_capacity_ = std::min(std::max(capacity, 1), 0xffff);
+    led_command_frame_.Reserve(led_capacity_);
+    led_command_mailbox_.Reserve(led_capacity_);
+    led_request_frame_.Reserve(led_capacity_);
+    led_stream_input_frame_.Reserve(led_capacity_);
+    led_mailbox_.Reserve(led_capacity_);
+    led_stream_frame_.Reserve(led_capacity_);
+    led_layer_frame_.Reserve(led_capacity_);
+    led_status_frame_.Reserve(led_capacity_);
+    led_effect_frame_.Reserve(led_capacity_);
+    led_compositor_.Reserve(led_capacity_);
+    led_output_.Reserve(led_capacity_);
+}
+
+bool Control::CheckLedCount(const char *request, size_t count)
+{
+    if(count <= led_capacity_)
+    {
+        return false;
+    }
+    ROS_WARN_THROTTLE(1, "LED - %s requests %zu LEDs, channel has %u", request, count, led_capacity_);
+    return true;
+}
+
+void Control::UpdateAutoDim()
+{
+    if(led_dim_start_s_ <= 0.0)
+    {
+        return;
+    }
+
+    double dim_s = (ros::Time::now() - led_start_time_).toSec() - led_dim_start_s_;
+    if(dim_s <= 0.0)
+    {
+        return;
+    }
+    double progress = (led_dim_ramp_s_ > 0.0) ? std::min(dim_s / led_dim_ramp_s_, 1.0) : 1.0;
+    double brightness = led_brightness_ + (led_dim_brightness_ - led_brightness_) * progress;
+
+    //bus is used only when brightness changes by visible step
+    uint8_t level = lround(std::min(std::max(brightness, 0.0), 1.0) * 255);
+    if(level == led_brightness_level_)
+    {
+        return;
+    }
+    led_brightness_level_ = level;
+    bus_.Post(BusExecutor::PRIORITY_LED, [this, level](PowerboardBackend &board) -> uint8_t
+    {
+        return led_output_.SetBrightness(board, level / 255.0);
+    });
+}
+
+void Control::OpenRecorder()
+{
+    //empty path disables recorder
+    std::string path;
+    int records;
+    private_nh_.param<std::string>("recorder/path", path, name_.empty() ? RECORDER_DEFAULT_PATH : RECORDER_DEFAULT_DIR "/ae_powerboard_control_" + name_ + ".rec");
+    private_nh_.param<int>("recorder/records", records, RECORDER_DEFAULT_RECORDS);
+
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        recorded_esc_error_log_[i] = FlightRecorder::Make(0, 0);
+        recorded_esc_data_log_[i] = FlightRecorder::Make(0, 0);
+    }
+    recorded_board_status_ = FlightRecorder::Make(0, 0);
+
+    if(path.empty())
+    {
+        return;
+    }
+    if(records <= 0 || recorder_.Open(path, records))
+    {
+        ROS_WARN("Flight recorder - cannot open %s, recording is disabled", path.c_str());
+        return;
+    }
+
+    ROS_INFO("Flight recorder - %s, %d records", path.c_str(), records);
+    FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_SESSION, ros::Time::now().toNSec());
+    recorder_.Record(record);
+}
+
+void Control::RecordLedFrame(uint8_t command, const LedFrame &frame)
+{
+    FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_LED_COMMAND, ros::Time::now().toNSec());
+    FlightLedCommand &led = record.payload.led;
+    led.command = command;
+    led.mask = frame.mask;
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        led.count[ch] = frame.colors[ch].size();
+        if(ch < LED_CHANNEL_AD && !frame.colors[ch].empty())
+        {
+            led.color[ch][0] = frame.colors[ch][0].r;
+            led.color[ch][1] = frame.colors[ch][0].g;
+            led.color[ch][2] = frame.colors[ch][0].b;
+        }
+    }
+    recorder_.Record(record);
 }
 
 void Control::SetupServices()
 {
     // servers
-    esc_dev_info_srv_ = nh_.advertiseService("/ae_powerboard_control/esc/get_dev_info", &Control::CallbackEscDeviceInfo, this);
-    esc_error_log_srv_ = nh_.advertiseService("/ae_powerboard_control/esc/get_error_log", &Control::CallbackEscErrorLog, this);
-    esc_data_log_srv_ = nh_.advertiseService("/ae_powerboard_control/esc/get_data_log", &Control::CallbackEscDataLog, this);
-    esc_resistance_srv_ = nh_.advertiseService("/ae_powerboard_control/esc/get_resistance", &Control::CallbackEscResistance, this);
-    board_dev_info_srv_ = nh_.advertiseService("/ae_powerboard_control/board/get_dev_info", &Control::CallbackBoardDeviceInfo, this);
-    led_set_custom_color_srv_ = nh_.advertiseService("/ae_powerboard_control/led/set_custom_color", &Control::CallbackLedCustomColor, this);
-    led_set_color_srv_ = nh_.advertiseService("/ae_powerboard_control/led/set_color", &Control::CallbackLedColor, this);
-    led_set_predefined_effect_srv_ = nh_.advertiseService("/ae_powerboard_control/led/set_predefined_effect", &Control::CallbackLedPredefinedEffect, this);
-    led_set_custom_effect_srv_ = nh_.advertiseService("/ae_powerboard_control/led/set_custom_effect", &Control::CallbackLedCustomEffect, this);
-    board_shutdown_srv_ = nh_.advertiseService("/ae_powerboard_control/board/shutdown", &Control::CallbackBoardShutdown, this);
+    esc_dev_info_srv_ = nh_.advertiseService("esc/get_dev_info", &Control::CallbackEscDeviceInfo, this);
+    esc_error_log_srv_ = nh_.advertiseService("esc/get_error_log", &Control::CallbackEscErrorLog, this);
+    esc_data_log_srv_ = nh_.advertiseService("esc/get_data_log", &Control::CallbackEscDataLog, this);
+    esc_resistance_srv_ = nh_.advertiseService("esc/get_resistance", &Control::CallbackEscResistance, this);
+    board_dev_info_srv_ = nh_.advertiseService("board/get_dev_info", &Control::CallbackBoardDeviceInfo, this);
+    led_set_custom_color_srv_ = nh_.advertiseService("led/set_custom_color", &Control::CallbackLedCustomColor, this);
+    led_set_color_srv_ = nh_.advertiseService("led/set_color", &Control::CallbackLedColor, this);
+    led_set_predefined_effect_srv_ = nh_.advertiseService("led/set_predefined_effect", &Control::CallbackLedPredefinedEffect, this);
+    led_set_custom_effect_srv_ = nh_.advertiseService("led/set_custom_effect", &Control::CallbackLedCustomEffect, this);
+    led_set_layer_srv_ = nh_.advertiseService("led/set_layer", &Control::CallbackLedLayer, this);
+    board_shutdown_srv_ = nh_.advertiseService("board/shutdown", &Control::CallbackBoardShutdown, this);
+    bus_stats_srv_ = nh_.advertiseService("bus/get_stats", &Control::CallbackBusStats, this);
+}
+
+void Control::SetupPublishers()
+{
+    bus_stats_pub_ = nh_.advertise<ae_powerboard_control::BusQueueStats>("bus/queue_stats", 1);
+    led_stats_pub_ = nh_.advertise<ae_powerboard_control::LedOutputStats>("led/output_stats", 1);
+    bus_metrics_pub_ = nh_.advertise<ae_powerboard_control::BusStats>("bus/stats", 1);
+    esc_error_log_pub_ = nh_.advertise<ae_powerboard_control::EscErrorLogs>("esc/error_log", 1, true);
+    esc_data_log_pub_ = nh_.advertise<ae_powerboard_control::EscDataLogs>("esc/data_log", 1, true);
+    esc_dev_info_pub_ = nh_.advertise<ae_powerboard_control::EscDevicesInfo>("esc/dev_info", 1, true);
+    esc_resistance_pub_ = nh_.advertise<ae_powerboard_control::EscResistances>("esc/resistance", 1, true);
+    powerboard_state_pub_ = nh_.advertise<ae_powerboard_control::PowerboardState>("state", 1);
+    esc_fault_events_pub_ = nh_.advertise<ae_powerboard_control::EscFaultEvents>("esc/fault_events", 10);
+    led_command_status_pub_ = nh_.advertise<ae_powerboard_control::LedCommandStatus>("led/cmd/status", 100);
+}
+
+void Control::SetupSubscribers()
+{
+    //streamed frames, only the latest one is kept
+    led_stream_sub_ = nh_.subscribe("led/frame", 1, &Control::CallbackLedStreamFrame, this, ros::TransportHints().tcpNoDelay());
+    //commands without reply, results are published on led/cmd/status
+    led_color_cmd_sub_ = nh_.subscribe("led/cmd/set_color", 10, &Control::CallbackLedColorCommand, this, ros::TransportHints().tcpNoDelay());
+    led_custom_color_cmd_sub_ = nh_.subscribe("led/cmd/set_custom_color", 10, &Control::CallbackLedCustomColorCommand, this, ros::TransportHints().tcpNoDelay());
+    led_predefined_effect_cmd_sub_ = nh_.subscribe("led/cmd/set_predefined_effect", 10, &Control::CallbackLedPredefinedEffectCommand, this, ros::TransportHints().tcpNoDelay());
+    led_custom_effect_cmd_sub_ = nh_.subscribe("led/cmd/set_custom_effect", 10, &Control::CallbackLedCustomEffectCommand, this, ros::TransportHints().tcpNoDelay());
 }
 
 void Control::SetupTimers()
 {
-    main_tim_ = nh_.createTimer(ros::Duration(MAIN_TIME_PERIOD_S), &Control::CallbackMainTimer, this);
-    state_tim_ = nh_.createTimer(ros::Duration(MAIN_TIME_PERIOD_S), &Control::CallbackStateTimer, this);
+    //rates are checked again every stats period, see UpdateRates
+    if(this->ReadRate("led_rate", led_rate_, false))
+    {
+        led_period_s_ = 1.0 / led_rate_;
+    }
+    this->ReadRate("board_status_rate", board_status_rate_, false);
+
+    main_tim_ = nh_.createTimer(ros::Duration(1.0 / led_rate_), &Control::CallbackMainTimer, this);
+    state_tim_ = nh_.createTimer(ros::Duration(1.0 / board_status_rate_), &Control::CallbackStateTimer, this);
+    stats_tim_ = nh_.createTimer(ros::Duration(STATS_TIME_PERIOD_S), &Control::CallbackStatsTimer, this);
+}
+
+bool Control::ReadRate(const std::string &name, double &rate, bool allow_zero)
+{
+    double value;
+    if(!private_nh_.getParamCached(name, value) || value == rate)
+    {
+        return false;
+    }
+    if(value < 0.0 || (value == 0.0 && !allow_zero))
+    {
+        ROS_WARN_THROTTLE(10, "Rates - invalid %s %.3f Hz, %.3f Hz is kept", name.c_str(), value, rate);
+        return false;
+    }
+
+    rate = value;
+    ROS_INFO("Rates - %s %.3f Hz", name.c_str(), rate);
+    return true;
+}
+
+void Control::SetTimerRate(ros::Timer &timer, double rate)
+{
+    //0 stops timer
+    if(rate > 0.0)
+    {
+        timer.setPeriod(ros::Duration(1.0 / rate));
+        timer.start();
+    }
+    else
+    {
+        timer.stop();
+    }
+}
+
+void Control::UpdateRates()
+{
+    if(this->ReadRate("led_rate", led_rate_, false))
+    {
+        led_period_s_ = 1.0 / led_rate_;
+        this->SetTimerRate(main_tim_, led_rate_);
+    }
+    if(this->ReadRate("board_status_rate", board_status_rate_, false))
+    {
+        this->SetTimerRate(state_tim_, board_status_rate_);
+    }
+    if(this->ReadRate("state_rate", state_rate_, true))
+    {
+        this->SetTimerRate(powerboard_state_tim_, state_rate_);
+    }
+
+    //scheduler is used only on telemetry timer, new rates are applied there
+    std::lock_guard<std::mutex> lock(telemetry_rates_mutex_);
+    for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+    {
+        if(this->ReadRate(std::string("telemetry/") + TelemetryScheduler::ClassName(i) + "_rate", telemetry_rates_[i], true))
+        {
+            telemetry_rates_changed_ |= (1 << i);
+        }
+    }
+}
+
+void Control::SetupTelemetry()
+{
+    //rates of full sweep over all ESCs in Hz, 0 disables polling of the class
+    double now_s = ros::Time::now().toSec();
+    for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+    {
+        this->ReadRate(std::string("telemetry/") + TelemetryScheduler::ClassName(i) + "_rate", telemetry_rates_[i], true);
+        telemetry_scheduler_.SetRate(i, telemetry_rates_[i], now_s);
+    }
+
+    //publish startup values
+    for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+    {
+        this->PublishTelemetry(i);
+    }
+
+    telemetry_tim_ = nh_.createTimer(ros::Duration(TELEMETRY_TIME_PERIOD_S), &Control::CallbackTelemetryTimer, this);
+
+    //aggregated state of board and all ESCs, 0 stops it
+    this->ReadRate("state_rate", state_rate_, true);
+    powerboard_state_tim_ = nh_.createTimer(ros::Duration(1.0), &Control::CallbackPowerboardStateTimer, this, false, false);
+    this->SetTimerRate(powerboard_state_tim_, state_rate_);
 }
 
 void Control::CallbackMainTimer(const ros::TimerEvent &event)
 {
-    static uint64_t ticks = 0;
+    this->UpdateAutoDim();
 
-    ticks++;
-    
     if(!led_effect_run_)
     {
         return;
     }
 
-    switch(led_effect_type_)
+    //effect is (re)started from its first frame, type and start are taken as one pair
+    if(led_effect_update_.exchange(false))
     {
-        case NO_EFFECT:
-            this->HandleNoEffect(ticks);
-            break;
-        case EFFECT_1:
-            this->HandleEffect_1(ticks);
-            break;
-        /*Add handling of user custom effects*/    
+        std::lock_guard<std::mutex> lock(led_effect_mutex_);
+        led_effect_player_.Start(led_effects_.Find(led_effect_type_), led_effect_start_);
+    }
+
+    //frame follows clock, late callback catches up
+    if(led_effect_player_.Tick(ros::Time::now(), led_effect_frame_))
+    {
+        this->CommitLedFrame(led_effect_frame_);
     }
 }
 
-void Control::CallbackStateTimer(const ros::TimerEvent &event)
+uint8_t Control::CommitLedFrame(const LedFrame &frame)
 {
-    static uint64_t ticks = 0;
-    static bool read_error = false;
+    return bus_.Execute(BusExecutor::PRIORITY_LED, [&](PowerboardBackend &board) -> uint8_t
+    {
+        return this->CommitLayer(board, LED_LAYER_BASE, frame, LED_BLEND_REPLACE);
+    });
+}
 
-    uint8_t status = drone_control_->PowerBoardStatusGet(&power_board_status_);
+uint8_t Control::CommitLayer(PowerboardBackend &board, uint8_t layer, const LedFrame &frame, uint8_t blend)
+{
+    //channels lost to predefined effect are composed again too
+    uint8_t dirty = led_compositor_.Set(layer, frame, blend);
+    dirty |= led_compositor_.Mask() & ~led_output_.ShownMask();
+    return led_output_.Commit(board, led_compositor_.Compose(dirty, frame.update_count));
+}
+
+void Control::CallbackStateTimer(const ros::TimerEvent &event)
+{
+    uint8_t board_status = program_state_run;
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_STATUS, [&](PowerboardBackend &board) -> uint8_t
+    {
+        uint8_t status = board.PowerBoardStatusGet(&board_status);
+        if(!status)
+        {
+            TelemetrySnapshot &telemetry = telemetry_.Edit();
+            telemetry.power_board_status = board_status;
+            telemetry.power_board_status_stamp = ros::Time::now();
+            telemetry_.Publish();
+
+            FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_BOARD_STATUS, telemetry.power_board_status_stamp.toNSec());
+            record.status = board_status;
+            recorder_.RecordChange(record, recorded_board_status_);
+        }
+        return status;
+    });
     if(status)
     {
-        if(!read_error)
+        if(!board_status_error_)
         {
-            read_error = true;
+            board_status_error_ = true;
             ROS_ERROR("PowerBoard status - problem reading data");
         }
     }
     else
     {
-        if(read_error)
+        if(board_status_error_)
         {
-            read_error = false;
+            board_status_error_ = false;
             ROS_WARN("PowerBoard status - problem reading data");
         }
-        
-        if(power_board_status_ == program_state_turning_off)
+
+        if(board_status == program_state_turning_off)
         {
+            if(bus_.IsSimulated())
+            {
+                ROS_WARN_THROTTLE(10, "PowerBoard is shutting down - ignored with simulated backend");
+                return;
+            }
             ROS_WARN("PowerBoard is shutting down");
+            //other boards of process lose their records too
+            FlightRecorder::FlushAll();
             sync();
             reboot(LINUX_REBOOT_CMD_POWER_OFF);
         }
     }
 }
 
+void Control::CallbackTelemetryTimer(const ros::TimerEvent &event)
+{
+    if(i2c_error_)
+    {
+        return;
+    }
+
+    double now_s = ros::Time::now().toSec();
+    //classes with unchanged rate keep their schedule
+    uint8_t rates_changed = telemetry_rates_changed_.exchange(0);
+    if(rates_changed)
+    {
+        std::lock_guard<std::mutex> lock(telemetry_rates_mutex_);
+        for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+        {
+            if(rates_changed & (1 << i))
+            {
+                telemetry_scheduler_.SetRate(i, telemetry_rates_[i], now_s);
+            }
+        }
+    }
+
+    //one esc read per tick, bus stays free for leds and status in between
+    uint8_t data_class, esc_index;
+    if(telemetry_scheduler_.Next(now_s, data_class, esc_index))
+    {
+        this->ReadEsc(data_class, esc_index, false);
+        this->PublishTelemetry(data_class);
+    }
+
+    this->UpdateLedStatus();
+}
+
+void Control::UpdateLedStatus()
+{
+    if(!led_status_.IsEnabled())
+    {
+        return;
+    }
+
+    //arms are rendered only when their level changes
+    uint8_t changed = led_status_.Update(telemetry_.Read());
+    if(!changed)
+    {
+        return;
+    }
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        if(changed & LED_CHANNEL_MASK(i))
+        {
+            ROS_INFO("LED STATUS - esc%u %s", i + 1, LedStatus::LevelName(led_status_.Level(i)));
+        }
+    }
+
+    //frame is reused, bus call waits until layer took it
+    LedFrame &frame = led_status_frame_;
+    frame.mask = 0;
+    frame.update_count = true;
+    uint8_t clear = 0;
+    led_status_.Render(changed, frame, clear);
+    bus_.Execute(BusExecutor::PRIORITY_LED, [&](PowerboardBackend &board) -> uint8_t
+    {
+        //arms back to ok show layers below
+        uint8_t dirty = led_compositor_.Clear(LED_LAYER_ESC_STATUS, clear);
+        dirty |= led_compositor_.Set(LED_LAYER_ESC_STATUS, frame, LED_BLEND_REPLACE);
+
+        uint8_t status = 0;
+        if(frame.mask)
+        {
+            //overlay is shown only from buffers
+            status = led_output_.SwitchPredefinedEffect(board, false);
+        }
+        else if(!dirty || led_output_.PredefinedEnabled())
+        {
+            //nothing was shown or board renders predefined effect, it keeps running
+            return 0;
+        }
+        dirty |= led_compositor_.Mask() & ~led_output_.ShownMask();
+        return status | led_output_.Commit(board, led_compositor_.Compose(dirty, frame.update_count));
+    });
+}
+
+bool Control::ReadEsc(uint8_t data_class, uint8_t i, bool verbose)
+{
+    switch(data_class)
+    {
+        case TELEMETRY_ERROR_LOG:
+            return this->ReadEscErrorLog(i, verbose);
+        case TELEMETRY_DATA_LOG:
+            return this->ReadEscDataLog(i, verbose);
+        case TELEMETRY_DEVICE_INFO:
+            return this->ReadEscDeviceInfo(i, verbose);
+        case TELEMETRY_RESISTANCE:
+            return this->ReadEscResistance(i, verbose);
+        default:
+            return false;
+    }
+}
+
+uint8_t Control::RequestedEscMask(const std::vector<uint8_t> &esc_numbers)
+{
+    if(esc_numbers.empty())
+    {
+        return TELEMETRY_ESC_MASK_ALL;
+    }
+
+    uint8_t esc_mask = 0x00;
+    for(size_t j = 0; j < esc_numbers.size(); j++)
+    {
+        uint8_t i = esc_numbers[j] - esc1;
+        if(i < TELEMETRY_ESC_COUNT)
+        {
+            esc_mask |= (1 << i);
+        }
+    }
+    return esc_mask;
+}
+
+void Control::RefreshEsc(uint8_t data_class, uint8_t esc_mask, double max_age, bool force_refresh)
+{
+    if(i2c_error_ || (!force_refresh && max_age <= 0.0))
+    {
+        return;
+    }
+
+    TelemetrySnapshot telemetry = telemetry_.Read();
+    ros::Time now = ros::Time::now();
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        if(!(esc_mask & (1 << i)))
+        {
+            continue;
+        }
+        if(!force_refresh && telemetry.IsEscFresh(data_class, i, now, max_age))
+        {
+            continue;
+        }
+        telemetry_refresh_.RunEsc(data_class, i, [this, data_class, i]() -> bool
+        {
+            return this->ReadEsc(data_class, i, false);
+        });
+    }
+}
+
+void Control::PublishTelemetry(uint8_t data_class)
+{
+    //messages are published as shared pointers, subscribers in same nodelet manager get them without copy
+    TelemetrySnapshot telemetry = telemetry_.Read();
+    ros::Time stamp = telemetry.stamp;
+    switch(data_class)
+    {
+        case TELEMETRY_ERROR_LOG:
+        {
+            ae_powerboard_control::EscErrorLogs::Ptr msg = boost::make_shared<ae_powerboard_control::EscErrorLogs>();
+            msg->stamp = stamp;
+            this->FillEscErrorLog(telemetry, TELEMETRY_ESC_MASK_ALL, msg->error_log);
+            esc_error_log_pub_.publish(msg);
+            break;
+        }
+        case TELEMETRY_DATA_LOG:
+        {
+            ae_powerboard_control::EscDataLogs::Ptr msg = boost::make_shared<ae_powerboard_control::EscDataLogs>();
+            msg->stamp = stamp;
+            this->FillEscDataLog(telemetry, TELEMETRY_ESC_MASK_ALL, msg->data_log);
+            esc_data_log_pub_.publish(msg);
+            break;
+        }
+        case TELEMETRY_DEVICE_INFO:
+        {
+            ae_powerboard_control::EscDevicesInfo::Ptr msg = boost::make_shared<ae_powerboard_control::EscDevicesInfo>();
+            msg->stamp = stamp;
+            this->FillEscDeviceInfo(telemetry, TELEMETRY_ESC_MASK_ALL, msg->devices_info);
+            esc_dev_info_pub_.publish(msg);
+            break;
+        }
+        case TELEMETRY_RESISTANCE:
+        {
+            ae_powerboard_control::EscResistances::Ptr msg = boost::make_shared<ae_powerboard_control::EscResistances>();
+            msg->stamp = stamp;
+            this->FillEscResistance(telemetry, TELEMETRY_ESC_MASK_ALL, msg->resistance);
+            esc_resistance_pub_.publish(msg);
+            break;
+        }
+    }
+}
+
+void Control::CallbackStatsTimer(const ros::TimerEvent &event)
+{
+    //published as shared pointers like telemetry, nodelets in same manager get them without copy
+    ae_powerboard_control::BusQueueStats::Ptr msg = boost::make_shared<ae_powerboard_control::BusQueueStats>();
+    msg->stamp = ros::Time::now();
+    for(uint8_t i = 0; i < BusExecutor::PRIORITY_COUNT; i++)
+    {
+        BusExecutor::Priority priority = (BusExecutor::Priority)i;
+        BusExecutor::QueueStats stats = bus_.ReadStats(priority);
+
+        ae_powerboard_control::BusQueue queue;
+        queue.name = BusExecutor::PriorityName(priority);
+        queue.depth = stats.depth;
+        queue.max_depth = stats.max_depth;
+        queue.executed = stats.executed;
+        queue.avg_wait = stats.avg_wait_s;
+        queue.max_wait = stats.max_wait_s;
+        msg->queues.push_back(queue);
+    }
+    bus_stats_pub_.publish(msg);
+
+    LedOutput::Stats led_stats = led_output_.ReadStats();
+    ae_powerboard_control::LedOutputStats::Ptr led_msg = boost::make_shared<ae_powerboard_control::LedOutputStats>();
+    led_msg->stamp = msg->stamp;
+    led_msg->frames = led_stats.frames;
+    led_msg->sent_bytes = led_stats.sent_bytes;
+    led_msg->skipped_bytes = led_stats.skipped_bytes;
+    led_msg->sent_channels = led_stats.sent_channels;
+    led_msg->skipped_channels = led_stats.skipped_channels;
+    led_msg->skipped_updates = led_stats.skipped_updates;
+    led_msg->skipped_config_writes = led_stats.skipped_config_writes;
+    led_msg->limited_frames = led_stats.limited_frames;
+    led_msg->estimated_current = led_stats.estimated_current_ma;
+    led_msg->brightness = led_brightness_level_ / 255.0;
+    LedMailbox::Stats stream_stats = led_mailbox_.ReadStats();
+    led_msg->stream_received = stream_stats.received;
+    led_msg->stream_applied = stream_stats.applied;
+    led_msg->stream_dropped = stream_stats.dropped;
+    LedMailbox::Stats command_stats = led_command_mailbox_.ReadStats();
+    led_msg->command_received = command_stats.received;
+    led_msg->command_applied = command_stats.applied;
+    led_msg->command_coalesced = command_stats.dropped;
+    LedEffectPlayer::Stats effect_stats = led_effect_player_.ReadStats();
+    led_msg->effect_frames = effect_stats.frames;
+    led_msg->effect_skipped_frames = effect_stats.skipped_frames;
+    led_effect_player_.ReadWindowPhaseError(led_msg->effect_phase_error_mean, led_msg->effect_phase_error_max);
+    led_stats_pub_.publish(led_msg);
+
+    //operation latencies in last period
+    BusMetrics::Snapshot snapshot = bus_.Metrics().Read();
+    ae_powerboard_control::BusStats::Ptr bus_msg = boost::make_shared<ae_powerboard_control::BusStats>();
+    this->FillBusStats(*bus_msg, snapshot, bus_metrics_last_, true);
+    bus_metrics_last_ = snapshot;
+    bus_metrics_pub_.publish(bus_msg);
+
+    this->UpdateRates();
+}
+
+void Control::FillBusStats(ae_powerboard_control::BusStats &msg, const BusMetrics::Snapshot &now, const BusMetrics::Snapshot &before, bool window)
+{
+    BusMetrics &metrics = bus_.Metrics();
+
+    msg.stamp = ros::Time::now();
+    msg.period = std::chrono::duration<double>(now.time - before.time).count();
+    msg.busy_fraction = BusMetrics::BusyFraction(now, before);
+    for(uint8_t i = 0; i < BusMetrics::OP_COUNT; i++)
+    {
+        BusMetrics::Operation operation = (BusMetrics::Operation)i;
+        BusMetrics::Summary summary = BusMetrics::Summarize(now.operations[i], before.operations[i]);
+
+        ae_powerboard_control::BusOperationStats stats;
+        stats.name = BusMetrics::OperationName(operation);
+        stats.count = summary.count;
+        stats.errors = summary.errors;
+        stats.mean = summary.mean_s;
+        stats.p50 = summary.p50_s;
+        stats.p99 = summary.p99_s;
+        stats.max = window ? metrics.ReadWindowMax(operation) : metrics.ReadMax(operation);
+        msg.operations.push_back(stats);
+    }
+}
+
+bool Control::CallbackBusStats(ae_powerboard_control::GetBusStats::Request &req, ae_powerboard_control::GetBusStats::Response &res)
+{
+    //whole run of the node
+    this->FillBusStats(res.stats, bus_.Metrics().Read(), bus_metrics_start_, false);
+    return true;
+}
+
 bool Control::CallbackBoardShutdown(std_srvs::SetBool::Request &req, std_srvs::SetBool::Response &res)
 {
     if (req.data)
     {
-        uint8_t status = drone_control_->DroneTurnOff();
+        uint8_t status = bus_.Execute(BusExecutor::PRIORITY_STATUS, [](PowerboardBackend &board) -> uint8_t
+        {
+            return board.DroneTurnOff();
+        });
         if(status)
         {
             ROS_ERROR("Board shutdown - problem writing data");
@@ -129,75 +757,380 @@ bool Control::CallbackBoardShutdown(std_srvs::SetBool::Request &req, std_srvs::S
         res.success = false;
         res.message = "Shutdown in service is disabled.";
     }
-    return true;
+    return true;
+}
+
+template<class T>
+bool Control::BuildLedColorFrame(const char *request, const T &command, LedFrame &frame)
+{
+    if(this->CheckLedCount(request, std::max(command.leds_count, command.enable_add ? command.leds_add_count : (uint16_t)0)))
+    {
+        return true;
+    }
+
+    frame.mask = 0;
+    frame.update_count = true;
+    frame.FillChannel(LED_CHANNEL_FL, *((const COLOR*)&command.leds_color), command.leds_count);
+    frame.FillChannel(LED_CHANNEL_FR, *((const COLOR*)&command.leds_color), command.leds_count);
+    frame.FillChannel(LED_CHANNEL_RL, *((const COLOR*)&command.leds_color), command.leds_count);
+    frame.FillChannel(LED_CHANNEL_RR, *((const COLOR*)&command.leds_color), command.leds_count);
+    if(command.enable_add)
+    {
+        frame.FillChannel(LED_CHANNEL_AD, *((const COLOR*)&command.add_color), command.leds_add_count);
+    }
+    return false;
+}
+
+template<class T>
+bool Control::BuildLedCustomColorFrame(const char *request, const T &command, LedFrame &frame)
+{
+    const ae_powerboard_control::LedChannel *channels[LED_CHANNEL_COUNT] = {&command.front_left, &command.front_right, &command.rear_left, &command.rear_right, &command.add};
+    uint8_t channels_count = command.enable_add ? LED_CHANNEL_COUNT : LED_CHANNEL_AD;
+    for(uint8_t ch = 0; ch < channels_count; ch++)
+    {
+        if(this->CheckLedCount(request, channels[ch]->color.size()))
+        {
+            return true;
+        }
+    }
+
+    //whole frame is copied from command colors
+    frame.mask = 0;
+    frame.update_count = true;
+    for(uint8_t ch = 0; ch < channels_count; ch++)
+    {
+        frame.SetChannel(ch, (const COLOR*)channels[ch]->color.data(), channels[ch]->color.size());
+    }
+    return false;
+}
+
+bool Control::CallbackLedColor(ae_powerboard_control::SetLedColor::Request &req, ae_powerboard_control::SetLedColor::Response &res)
+{
+    uint64_t ticket;
+    uint64_t discarded;
+    {
+        //frame buffers are sized in Init, put exchanges them with mailbox and they are never freed
+        std::lock_guard<std::mutex> lock(led_command_frame_mutex_);
+        if(i2c_error_ || this->BuildLedColorFrame("set_color", req, led_command_frame_))
+        {
+            res.success = false;
+            return true;
+        }
+
+        //turn off predefinned effect
+        led_effect_run_ = false;
+        this->RecordLedFrame(FLIGHT_LED_COLOR, led_command_frame_);
+        ticket = this->PutLedCommand(led_command_frame_, discarded);
+    }
+    if(discarded)
+    {
+        //topic commands merged into dropped frame are answered too
+        this->ReportLedCommands(discarded, BusExecutor::STATUS_NOT_RUNNING);
+    }
+
+    bool coalesced = false;
+    uint8_t status = led_command_mailbox_.Wait(ticket, LED_COMMAND_TIMEOUT_S, coalesced);
+
+    res.success = (status == 0);
+    res.coalesced = coalesced;
+    return true;
+}
+
+bool Control::CallbackLedCustomColor(ae_powerboard_control::SetLedCustomColor::Request &req, ae_powerboard_control::SetLedCustomColor::Response &res)
+{
+    uint64_t ticket;
+    uint64_t discarded;
+    {
+        std::lock_guard<std::mutex> lock(led_command_frame_mutex_);
+        if(i2c_error_ || this->BuildLedCustomColorFrame("set_custom_color", req, led_command_frame_))
+        {
+            res.success = false;
+            return true;
+        }
+
+        //turn off predefinned effect
+        led_effect_run_ = false;
+        this->RecordLedFrame(FLIGHT_LED_CUSTOM_COLOR, led_command_frame_);
+        ticket = this->PutLedCommand(led_command_frame_, discarded);
+    }
+    if(discarded)
+    {
+        //topic commands merged into dropped frame are answered too
+        this->ReportLedCommands(discarded, BusExecutor::STATUS_NOT_RUNNING);
+    }
+
+    bool coalesced = false;
+    uint8_t status = led_command_mailbox_.Wait(ticket, LED_COMMAND_TIMEOUT_S, coalesced);
+
+    res.success = (status == 0);
+    res.coalesced = coalesced;
+    return true;
+}
+
+void Control::CallbackLedColorCommand(const ae_powerboard_control::LedColorCommand::ConstPtr &msg)
+{
+    std::lock_guard<std::mutex> lock(led_command_frame_mutex_);
+    if(i2c_error_ || this->BuildLedColorFrame("cmd/set_color", *msg, led_command_frame_))
+    {
+        this->PublishLedCommandStatus(ae_powerboard_control::LedCommandStatus::SET_COLOR, msg->id, false, false);
+        return;
+    }
+
+    //turn off predefinned effect
+    led_effect_run_ = false;
+    this->RecordLedFrame(FLIGHT_LED_COLOR, led_command_frame_);
+    this->PostLedCommand(led_command_frame_, ae_powerboard_control::LedCommandStatus::SET_COLOR, msg->id);
+}
+
+void Control::CallbackLedCustomColorCommand(const ae_powerboard_control::LedCustomColorCommand::ConstPtr &msg)
+{
+    std::lock_guard<std::mutex> lock(led_command_frame_mutex_);
+    if(i2c_error_ || this->BuildLedCustomColorFrame("cmd/set_custom_color", *msg, led_command_frame_))
+    {
+        this->PublishLedCommandStatus(ae_powerboard_control::LedCommandStatus::SET_CUSTOM_COLOR, msg->id, false, false);
+        return;
+    }
+
+    //turn off predefinned effect
+    led_effect_run_ = false;
+    this->RecordLedFrame(FLIGHT_LED_CUSTOM_COLOR, led_command_frame_);
+    this->PostLedCommand(led_command_frame_, ae_powerboard_control::LedCommandStatus::SET_CUSTOM_COLOR, msg->id);
+}
+
+void Control::CallbackLedPredefinedEffectCommand(const ae_powerboard_control::LedPredefinedEffectCommand::ConstPtr &msg)
+{
+    //effects are rare, command is passed through service path
+    ae_powerboard_control::SetLedPredefinedEffect::Request req;
+    ae_powerboard_control::SetLedPredefinedEffect::Response res;
+    req.leds_count = msg->leds_count;
+    req.on_led_cycles = msg->on_led_cycles;
+    req.off_led_cycles = msg->off_led_cycles;
+    req.effect_type = msg->effect_type;
+    req.front_left = msg->front_left;
+    req.front_right = msg->front_right;
+    req.rear_left = msg->rear_left;
+    req.rear_right = msg->rear_right;
+    req.set_default = msg->set_default;
+    this->CallbackLedPredefinedEffect(req, res);
+    this->PublishLedCommandStatus(ae_powerboard_control::LedCommandStatus::SET_PREDEFINED_EFFECT, msg->id, res.success, false);
+}
+
+void Control::CallbackLedCustomEffectCommand(const ae_powerboard_control::LedCustomEffectCommand::ConstPtr &msg)
+{
+    ae_powerboard_control::SetLedCustomEffect::Request req;
+    ae_powerboard_control::SetLedCustomEffect::Response res;
+    req.effect_type = msg->effect_type;
+    req.kill_predefined_effect = msg->kill_predefined_effect;
+    req.start = msg->start;
+    this->CallbackLedCustomEffect(req, res);
+    this->PublishLedCommandStatus(ae_powerboard_control::LedCommandStatus::SET_CUSTOM_EFFECT, msg->id, res.success, false);
+}
+
+void Control::CallbackLedStreamFrame(const ae_powerboard_control::LedStreamFrame::ConstPtr &msg)
+{
+    if(i2c_error_)
+    {
+        return;
+    }
+
+    //frame is reused, put swaps it with buffers of mailbox
+    LedFrame &frame = led_stream_input_frame_;
+    frame.mask = 0;
+    frame.update_count = msg->update_count;
+    const ae_powerboard_control::LedChannel *channels[LED_CHANNEL_COUNT] = {&msg->front_left, &msg->front_right, &msg->rear_left, &msg->rear_right, &msg->add};
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if(msg->channels & LED_CHANNEL_MASK(ch))
+        {
+            if(this->CheckLedCount("led/frame", channels[ch]->color.size()))
+            {
+                return;
+            }
+            frame.SetChannel(ch, (COLOR*)channels[ch]->color.data(), channels[ch]->color.size());
+        }
+    }
+
+    //turn off predefinned effect, only accepted frame stops it
+    led_effect_run_ = false;
+
+    //bus is woken only for empty mailbox, queued drain picks up the latest frame
+    if(led_mailbox_.Put(frame))
+    {
+        uint8_t status = bus_.Post(BusExecutor::PRIORITY_LED, [this](PowerboardBackend &board) -> uint8_t
+        {
+            return this->DrainLedMailbox(board);
+        });
+        if(status)
+        {
+            //no drain is queued, next frame has to wake bus again
+            uint64_t ticket;
+            led_mailbox_.Discard(status, ticket);
+        }
+    }
+}
+
+uint8_t Control::DrainLedMailbox(PowerboardBackend &board)
+{
+    uint64_t ticket;
+    if(!led_mailbox_.Take(led_stream_frame_, ticket))
+    {
+        return 0;
+    }
+
+    uint8_t status = led_output_.SwitchPredefinedEffect(board, false);
+    status |= this->CommitLayer(board, LED_LAYER_BASE, led_stream_frame_, LED_BLEND_REPLACE);
+    led_mailbox_.Complete(ticket, status);
+    return status;
+}
+
+uint64_t Control::PutLedCommand(LedFrame &frame, uint64_t &discarded)
+{
+    //burst of commands is collapsed to latest state, written at most once per output period
+    uint64_t ticket;
+    discarded = 0;
+    if(led_command_mailbox_.Put(frame, ticket))
+    {
+        uint8_t status = bus_.PostDelayed(BusExecutor::PRIORITY_LED, led_command_mailbox_.TakeDelay(led_period_s_), [this](PowerboardBackend &board) -> uint8_t
+        {
+            return this->FlushLedCommand(board);
+        });
+        if(status && !led_command_mailbox_.Discard(status, discarded))
+        {
+            discarded = 0;
+        }
+    }
+    return ticket;
+}
+
+void Control::PostLedCommand(LedFrame &frame, uint8_t command, uint32_t id)
+{
+    uint64_t discarded;
+    {
+        //flush can not report ticket before it is listed, both are done under same lock
+        std::lock_guard<std::mutex> lock(led_topic_mutex_);
+        LedTopicCommand topic_command;
+        topic_command.ticket = this->PutLedCommand(frame, discarded);
+        topic_command.command = command;
+        topic_command.id = id;
+        led_topic_commands_.push_back(topic_command);
+    }
+    if(discarded)
+    {
+        this->ReportLedCommands(discarded, BusExecutor::STATUS_NOT_RUNNING);
+    }
+}
+
+void Control::ReportLedCommands(uint64_t ticket, uint8_t status)
+{
+    //topic commands up to written ticket are done, older ones were replaced by it
+    std::lock_guard<std::mutex> lock(led_topic_mutex_);
+    while(!led_topic_commands_.empty() && led_topic_commands_.front().ticket <= ticket)
+    {
+        const LedTopicCommand &topic_command = led_topic_commands_.front();
+        this->PublishLedCommandStatus(topic_command.command, topic_command.id, status == 0, topic_command.ticket != ticket);
+        led_topic_commands_.pop_front();
+    }
+}
+
+void Control::PublishLedCommandStatus(uint8_t command, uint32_t id, bool success, bool coalesced)
+{
+    ae_powerboard_control::LedCommandStatus::Ptr msg = boost::make_shared<ae_powerboard_control::LedCommandStatus>();
+    msg->stamp = ros::Time::now();
+    msg->command = command;
+    msg->id = id;
+    msg->success = success;
+    msg->coalesced = coalesced;
+    led_command_status_pub_.publish(msg);
+}
+
+uint8_t Control::FlushLedCommand(PowerboardBackend &board)
+{
+    uint64_t ticket;
+    if(!led_command_mailbox_.Take(led_request_frame_, ticket))
+    {
+        return 0;
+    }
+
+    uint8_t status = led_output_.SwitchPredefinedEffect(board, false);
+    status |= this->CommitLayer(board, LED_LAYER_BASE, led_request_frame_, LED_BLEND_REPLACE);
+    led_command_mailbox_.Complete(ticket, status);
+    this->ReportLedCommands(ticket, status);
+    return status;
 }
 
-void Control::HandleEffect_1(uint64_t ticks)
+bool Control::CallbackLedCustomEffect(ae_powerboard_control::SetLedCustomEffect::Request &req, ae_powerboard_control::SetLedCustomEffect::Response &res)
 {
-    static bool front_switcher = false;
-    static bool rear_switcher = false;
-    static uint64_t tick_offset = 0;
-    static COLOR color_buffer_front_d[LED_COUNT_EFFECT] = {WHITE, WHITE, WHITE, WHITE, OFFCOLOR, OFFCOLOR, OFFCOLOR, OFFCOLOR};
-    static COLOR color_buffer_front_r[LED_COUNT_EFFECT] = {OFFCOLOR, OFFCOLOR, OFFCOLOR, OFFCOLOR, WHITE, WHITE, WHITE, WHITE};
-    static COLOR color_buffer_rear_d[LED_COUNT_EFFECT] = {RED, RED, RED, RED, OFFCOLOR, OFFCOLOR, OFFCOLOR, OFFCOLOR};
-    static COLOR color_buffer_rear_r[LED_COUNT_EFFECT] = {OFFCOLOR, OFFCOLOR, OFFCOLOR, OFFCOLOR, RED, RED, RED, RED};
+    //refused request keeps running effect
+    const LedEffect *effect = led_effects_.Find(req.effect_type);
+    if(!effect)
+    {
+        ROS_WARN("LED EFFECT - unknown effect %u", req.effect_type);
+        res.success = false;
+        return true;
+    }
 
-    bool update_color = false;
+    //turn off predefinned effect
+    led_effect_run_ = false;
 
-    if(led_effect_update_)
+    FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_LED_COMMAND, ros::Time::now().toNSec());
+    record.payload.led.command = FLIGHT_LED_CUSTOM_EFFECT;
+    record.payload.led.mask = effect->mask;
+    record.payload.led.effect_type = req.effect_type;
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
     {
-        tick_offset = ticks;
-        front_switcher = false;
-        rear_switcher = false;
-
-        led_effect_update_ = false;
+        record.payload.led.count[ch] = (effect->mask & LED_CHANNEL_MASK(ch)) ? effect->leds_count : 0;
     }
+    recorder_.Record(record);
 
-    if((ticks - tick_offset) % 4 == 0)
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_LED, [&](PowerboardBackend &board) -> uint8_t
     {
-        front_switcher = !front_switcher;
-        update_color = true;
-    }
+        uint8_t status = 0;
+        if(req.kill_predefined_effect)
+        {
+            status |= led_output_.SwitchPredefinedEffect(board, false);
+        }
+
+        //update led count
+        return status | led_output_.CommitCount(board, effect->mask, effect->leds_count);
+    });
 
-    if((ticks - tick_offset) % 8 == 0)
+    //effect is not started on board which did not take its led count
+    if(status)
     {
-        rear_switcher = !rear_switcher;
-        update_color = true;
+        res.success = false;
+        return true;
     }
 
-    if(update_color)
+    ros::Time start;
+    if(!req.start.isZero())
     {
-        led_control_->LedsSendColorBuffer(fl_buffer, (front_switcher ? color_buffer_front_d : color_buffer_front_r), LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(fr_buffer, (front_switcher ? color_buffer_front_d : color_buffer_front_r), LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(rl_buffer, (rear_switcher ? color_buffer_rear_d : color_buffer_rear_r), LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(rr_buffer, (rear_switcher ? color_buffer_rear_d : color_buffer_rear_r), LED_COUNT_EFFECT);
-
-        led_control_->LedsUpdate();
+        start = req.start;
     }
-}
-
-void Control::HandleNoEffect(uint64_t ticks)
-{
-    if(led_effect_update_)
+    else if(!led_effect_epoch_.isZero())
     {
-        //prepartion of color
-        COLOR color_buffer[LED_COUNT_EFFECT];
-        led_control_->LedsSetBufferWithOneColor(color_buffer, OFFCOLOR, LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(fl_buffer, color_buffer, LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(fr_buffer, color_buffer, LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(rl_buffer, color_buffer, LED_COUNT_EFFECT);
-        led_control_->LedsSendColorBuffer(rr_buffer, color_buffer, LED_COUNT_EFFECT);
-        
-        //update led buffer
-        led_control_->LedsUpdate();
-
-        led_effect_update_ = false;
+        start = led_effect_epoch_;
+    }
+    else
+    {
+        start = ros::Time::now();
+    }
+    {
+        std::lock_guard<std::mutex> lock(led_effect_mutex_);
+        led_effect_type_ = req.effect_type;
+        led_effect_start_ = start;
     }
+    //update is visible before run, main timer never ticks previous effect after this request
+    led_effect_update_ = true;
+    led_effect_run_ = true;
+
+    res.success = true;
+    return true;
 }
 
-bool Control::CallbackLedColor(ae_powerboard_control::SetLedColor::Request &req, ae_powerboard_control::SetLedColor::Response &res)
+bool Control::CallbackLedPredefinedEffect(ae_powerboard_control::SetLedPredefinedEffect::Request &req, ae_powerboard_control::SetLedPredefinedEffect::Response &res)
 {
-    if(i2c_error_)
+    //refused request keeps running effect
+    if(this->CheckLedCount("set_predefined_effect", req.leds_count) || i2c_error_)
     {
         res.success = false;
         return true;
@@ -205,278 +1138,341 @@ bool Control::CallbackLedColor(ae_powerboard_control::SetLedColor::Request &req,
 
     //turn off predefinned effect
     led_effect_run_ = false;
-    led_control_->LedsSwitchPredefinedEffect(false);
-    
-    //update led count
-    LEDS_COUNT leds_count;
-    led_control_->LedsGetLedsCount(leds_count);
-    leds_count.fl_leds_count = req.leds_count;
-    leds_count.fr_leds_count = req.leds_count;
-    leds_count.rl_leds_count = req.leds_count;
-    leds_count.rr_leds_count = req.leds_count;
-    if(req.enable_add)
-    {
-        leds_count.ad_leds_count = req.leds_add_count;
-    }
-    led_control_->LedsSetLedsCount(leds_count);
-    
-    //front_left
-    COLOR color_buffer_fl[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_fl, *((COLOR*)&req.leds_color), req.leds_count);
-    led_control_->LedsSendColorBuffer(fl_buffer, color_buffer_fl, req.leds_count);
-
-    //front_right
-    COLOR color_buffer_fr[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_fr, *((COLOR*)&req.leds_color), req.leds_count);
-    led_control_->LedsSendColorBuffer(fr_buffer, color_buffer_fr, req.leds_count);
-
-    //rear_left
-    COLOR color_buffer_rl[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_rl, *((COLOR*)&req.leds_color), req.leds_count);
-    led_control_->LedsSendColorBuffer(rl_buffer, color_buffer_rl, req.leds_count);
-
-    //rear_right
-    COLOR color_buffer_rr[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_rr, *((COLOR*)&req.leds_color), req.leds_count);
-    led_control_->LedsSendColorBuffer(rr_buffer, color_buffer_rr, req.leds_count);
-
-    //additional
-    if(req.enable_add)
-    {
-        COLOR color_buffer_ad[req.leds_count];
-        led_control_->LedsSetBufferWithOneColor(color_buffer_ad, *((COLOR*)&req.add_color), req.leds_add_count);
-        led_control_->LedsSendColorBuffer(ad_buffer, color_buffer_ad, req.leds_add_count);
-    }
-
-    //update led buffer
-    led_control_->LedsUpdate();
 
-    res.success = true;
+    LedPredefinedEffect effect;
+    effect.front_left = *((COLOR*)&req.front_left);
+    effect.front_right = *((COLOR*)&req.front_right);
+    effect.rear_left = *((COLOR*)&req.rear_left);
+    effect.rear_right = *((COLOR*)&req.rear_right);
+    effect.on_led_cycles = req.on_led_cycles;
+    effect.off_led_cycles = req.off_led_cycles;
+    effect.effect_type = req.effect_type;
+    effect.set_default = req.set_default;
+
+    FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_LED_COMMAND, ros::Time::now().toNSec());
+    record.payload.led.command = FLIGHT_LED_PREDEFINED_EFFECT;
+    record.payload.led.mask = LED_CHANNEL_MASK_ARMS;
+    record.payload.led.effect_type = req.effect_type;
+    const COLOR *colors[4] = {&effect.front_left, &effect.front_right, &effect.rear_left, &effect.rear_right};
+    for(uint8_t ch = LED_CHANNEL_FL; ch <= LED_CHANNEL_RR; ch++)
+    {
+        record.payload.led.count[ch] = req.leds_count;
+        record.payload.led.color[ch][0] = colors[ch]->r;
+        record.payload.led.color[ch][1] = colors[ch]->g;
+        record.payload.led.color[ch][2] = colors[ch]->b;
+    }
+    recorder_.Record(record);
+
+    //only changed configuration is written
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_LED, [&](PowerboardBackend &board) -> uint8_t
+    {
+        //board renders arms by itself, base layer gives them up
+        uint8_t status = led_output_.CommitPredefinedEffect(board, effect, req.leds_count);
+        led_compositor_.Clear(LED_LAYER_BASE, LED_CHANNEL_MASK_ARMS);
+        return status;
+    });
+
+    res.success = (status == 0);
     return true;
 }
 
-bool Control::CallbackLedCustomColor(ae_powerboard_control::SetLedCustomColor::Request &req, ae_powerboard_control::SetLedCustomColor::Response &res)
+bool Control::CallbackLedLayer(ae_powerboard_control::SetLedLayer::Request &req, ae_powerboard_control::SetLedLayer::Response &res)
 {
     if(i2c_error_)
     {
         res.success = false;
+        res.message = "i2c error";
         return true;
     }
-
-    //turn off predefinned effect
-    led_effect_run_ = false;
-    led_control_->LedsSwitchPredefinedEffect(false);
-    
-    //update led count
-    LEDS_COUNT leds_count;
-    led_control_->LedsGetLedsCount(leds_count);
-    leds_count.fl_leds_count = req.front_left.color.size();
-    leds_count.fr_leds_count = req.front_right.color.size();
-    leds_count.rl_leds_count = req.rear_left.color.size();
-    leds_count.rr_leds_count = req.rear_right.color.size();
-    if(req.enable_add)
+    //srv numbers client layers, esc status layer between them is reserved for LedStatus
+    static const uint8_t client_layers[] = {LED_LAYER_BASE, LED_LAYER_STATUS, LED_LAYER_SAFETY};
+    if(req.layer >= sizeof(client_layers) / sizeof(client_layers[0]) || req.blend >= LED_BLEND_COUNT)
+    {
+        res.success = false;
+        res.message = "unknown layer or blend mode";
+        return true;
+    }
+    uint8_t layer = client_layers[req.layer];
+    //base layer has no owner, set_color, set_custom_color, effects and led/frame write it
+    if(layer == LED_LAYER_BASE)
+    {
+        res.success = false;
+        res.message = "base layer is written by led services, use status or safety layer";
+        return true;
+    }
+    if(req.owner.empty())
     {
-        leds_count.ad_leds_count = req.add.color.size();
+        res.success = false;
+        res.message = "owner must not be empty";
+        return true;
     }
-    led_control_->LedsSetLedsCount(leds_count);
 
-    //front_left
-    COLOR color_buffer_fl[req.front_left.color.size()];
-    memcpy(color_buffer_fl, req.front_left.color.data(), req.front_left.color.size()*sizeof(COLOR));
-    led_control_->LedsSendColorBuffer(fl_buffer, color_buffer_fl, req.front_left.color.size());
+    const ae_powerboard_control::LedChannel *channels[LED_CHANNEL_COUNT] = {&req.front_left, &req.front_right, &req.rear_left, &req.rear_right, &req.add};
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if((req.channels & LED_CHANNEL_MASK(ch)) && this->CheckLedCount("set_layer", channels[ch]->color.size()))
+        {
+            res.success = false;
+            res.message = "more colors than leds in channel";
+            return true;
+        }
+    }
 
-    //front_right
-    COLOR color_buffer_fr[req.front_right.color.size()];
-    memcpy(color_buffer_fr, req.front_right.color.data(), req.front_right.color.size()*sizeof(COLOR));
-    led_control_->LedsSendColorBuffer(fr_buffer, color_buffer_fr, req.front_right.color.size());
+    bool owned = false;
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_LED, [&](PowerboardBackend &board) -> uint8_t
+    {
+        if(led_compositor_.Claim(layer, req.owner))
+        {
+            owned = true;
+            return 0;
+        }
 
-    //rear_left
-    COLOR color_buffer_rl[req.rear_left.color.size()];
-    memcpy(color_buffer_rl, req.rear_left.color.data(), req.rear_left.color.size()*sizeof(COLOR));
-    led_control_->LedsSendColorBuffer(rl_buffer, color_buffer_rl, req.rear_left.color.size());
+        //colors are copied straight from request into frame of bus thread
+        LedFrame &frame = led_layer_frame_;
+        frame.mask = 0;
+        frame.update_count = false;
+        if(!req.release)
+        {
+            for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+            {
+                if(req.channels & LED_CHANNEL_MASK(ch))
+                {
+                    frame.SetChannel(ch, (COLOR*)channels[ch]->color.data(), channels[ch]->color.size());
+                }
+            }
+        }
 
-    //rear_right
-    COLOR color_buffer_rr[req.rear_right.color.size()];
-    memcpy(color_buffer_rr, req.rear_right.color.data(), req.rear_right.color.size()*sizeof(COLOR));
-    led_control_->LedsSendColorBuffer(rr_buffer, color_buffer_rr, req.rear_right.color.size());
+        //layers are shown only from buffers
+        uint8_t status = led_output_.SwitchPredefinedEffect(board, false);
+        uint8_t dirty = led_compositor_.Clear(layer, req.release ? (uint8_t)LED_CHANNEL_MASK_ALL : req.clear_channels);
+        if(req.release)
+        {
+            led_compositor_.Release(layer);
+        }
+        dirty |= led_compositor_.Set(layer, frame, req.blend);
+        dirty |= led_compositor_.Mask() & ~led_output_.ShownMask();
+        return status | led_output_.Commit(board, led_compositor_.Compose(dirty, false));
+    });
 
-    //additional
-    if(req.enable_add)
+    if(owned)
     {
-        COLOR color_buffer_ad[req.add.color.size()];
-        memcpy(color_buffer_ad, req.add.color.data(), req.add.color.size()*sizeof(COLOR));
-        led_control_->LedsSendColorBuffer(ad_buffer, color_buffer_ad, req.add.color.size());
+        res.success = false;
+        res.message = std::string(LedCompositor::LayerName(layer)) + " layer is owned by another client";
+        return true;
     }
+    res.success = (status == 0);
+    return true;
+}
 
-    //update led buffercolor_buffer_rr
-    led_control_->LedsUpdate();
-
-    res.success = true;
+bool Control::CallbackEscDeviceInfo(ae_powerboard_control::GetEscDeviceInfo::Request &req, ae_powerboard_control::GetEscDeviceInfo::Response &res)
+{
+    uint8_t esc_mask = this->RequestedEscMask(req.esc_numbers);
+    this->RefreshEsc(TELEMETRY_DEVICE_INFO, esc_mask, req.max_age, req.force_refresh);
+    this->FillEscDeviceInfo(telemetry_.Read(), esc_mask, res.devices_info);
     return true;
 }
 
-bool Control::CallbackLedCustomEffect(ae_powerboard_control::SetLedCustomEffect::Request &req, ae_powerboard_control::SetLedCustomEffect::Response &res)
+void Control::FillEscDeviceInfo(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscDeviceInfo> &devices_info)
 {
-    //turn off predefinned effect
-    led_effect_run_ = false;
-    if(req.kill_predefined_effect)  
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
     {
-        led_control_->LedsSwitchPredefinedEffect(false);
-    }    
+        if(!(esc_mask & (1 << i)))
+        {
+            continue;
+        }
+        devices_info.push_back(ae_powerboard_control::EscDeviceInfo());
+        this->FillEscDeviceInfo(telemetry, i, devices_info.back());
+    }
+}
 
-    //update led count
-    LEDS_COUNT leds_count;
-    led_control_->LedsGetLedsCount(leds_count);
-    leds_count.fl_leds_count = LED_COUNT_EFFECT;
-    leds_count.fr_leds_count = LED_COUNT_EFFECT;
-    leds_count.rl_leds_count = LED_COUNT_EFFECT;
-    leds_count.rr_leds_count = LED_COUNT_EFFECT;
-    led_control_->LedsSetLedsCount(leds_count);
+void Control::FillEscDeviceInfo(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscDeviceInfo &dev_info)
+{
+    dev_info.esc_number = esc1 + i;
+    dev_info.hw_build = telemetry.esc_device_info[i].hw_build;
+    dev_info.serial_number = telemetry.esc_device_info[i].serial_number;
+    dev_info.diagnostic_status = telemetry.esc_device_info[i].Diagnostic_status;
+    dev_info.address = telemetry.esc_device_info[i].device_address;
+    dev_info.test = telemetry.esc_device_info[i].hw_build & 0x01;
+    dev_info.fw_version.high = telemetry.esc_device_info[i].fw_number.major;
+    dev_info.fw_version.mid = telemetry.esc_device_info[i].fw_number.mid;
+    dev_info.fw_version.low = telemetry.esc_device_info[i].fw_number.minor;
+    dev_info.valid = telemetry.esc_device_info_status & (1 << i);
+}
 
-    led_effect_type_ = req.effect_type;
-    led_effect_run_ = true;
-    led_effect_update_ = true;
+bool Control::CallbackBoardDeviceInfo(ae_powerboard_control::GetBoardDeviceInfo::Request &req, ae_powerboard_control::GetBoardDeviceInfo::Response &res)
+{
+    if(!i2c_error_ && (req.force_refresh || req.max_age > 0.0))
+    {
+        if(req.force_refresh || !telemetry_.Read().IsBoardFresh(ros::Time::now(), req.max_age))
+        {
+            telemetry_refresh_.RunBoard([this]() -> bool
+            {
+                return this->ReadBoardDeviceInfo(false);
+            });
+        }
+    }
 
-    res.success = true;
+    this->FillBoardDeviceInfo(telemetry_.Read(), res.device_info);
     return true;
 }
 
-bool Control::CallbackLedPredefinedEffect(ae_powerboard_control::SetLedPredefinedEffect::Request &req, ae_powerboard_control::SetLedPredefinedEffect::Response &res)
+void Control::FillBoardDeviceInfo(const TelemetrySnapshot &telemetry, ae_powerboard_control::BoardDeviceInfo &dev_info)
 {
-    //turn off predefinned effect
-    led_effect_run_ = false;
-    led_control_->LedsSwitchPredefinedEffect(false);
-
-    //update led count
-    LEDS_COUNT leds_count;
-    led_control_->LedsGetLedsCount(leds_count);
-    leds_count.fl_leds_count = req.leds_count;
-    leds_count.fr_leds_count = req.leds_count;
-    leds_count.rl_leds_count = req.leds_count;
-    leds_count.rr_leds_count = req.leds_count;
-    led_control_->LedsSetLedsCount(leds_count);
-
-    //front_left
-    COLOR color_buffer_fl[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_fl, *((COLOR*)&req.front_left), req.leds_count);
-
-    //front_right
-    COLOR color_buffer_fr[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_fr, *((COLOR*)&req.front_right), req.leds_count);
-
-    //rear_leftcolor_buffer_rr
-    COLOR color_buffer_rl[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_rl, *((COLOR*)&req.rear_left), req.leds_count);
+    dev_info.hw_build = telemetry.board_device_info.hw_build;
+    dev_info.serial_number = telemetry.board_device_info.serial_number;
+    dev_info.test = telemetry.board_device_info.hw_build & 0x01;
+    dev_info.fw_version.high = telemetry.board_device_info.fw_number.major;
+    dev_info.fw_version.mid = telemetry.board_device_info.fw_number.mid;
+    dev_info.fw_version.low = telemetry.board_device_info.fw_number.minor;
+    dev_info.valid = telemetry.board_device_info_status;
+}
 
-    //rear_right
-    COLOR color_buffer_rr[req.leds_count];
-    led_control_->LedsSetBufferWithOneColor(color_buffer_rr, *((COLOR*)&req.rear_right), req.leds_count);
+void Control::CallbackPowerboardStateTimer(const ros::TimerEvent &event)
+{
+    TelemetrySnapshot telemetry = telemetry_.Read();
 
-    //set predefined effect
-    led_control_->LedsSetPredefinedEffect(*((COLOR*)&req.front_left), *((COLOR*)&req.front_right), *((COLOR*)&req.rear_left), *((COLOR*)&req.rear_right), req.on_led_cycles, req.off_led_cycles, req.effect_type, req.set_default);
+    ae_powerboard_control::PowerboardState::Ptr msg = boost::make_shared<ae_powerboard_control::PowerboardState>();
+    msg->stamp = telemetry.stamp;
+    msg->board_status = telemetry.power_board_status;
+    msg->board_status_stamp = telemetry.power_board_status_stamp;
+    this->FillBoardDeviceInfo(telemetry, msg->board_info);
+    msg->board_info_stamp = telemetry.board_device_info_stamp;
 
-    //update led buffer
-    led_control_->LedsUpdate();
+    msg->escs.resize(TELEMETRY_ESC_COUNT);
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        ae_powerboard_control::EscState &esc = msg->escs[i];
+        esc.esc_number = esc1 + i;
+        this->FillEscDeviceInfo(telemetry, i, esc.device_info);
+        esc.device_info_stamp = telemetry.esc_device_info_stamp[i];
+        this->FillEscErrorLog(telemetry, i, esc.error_log);
+        esc.error_log_stamp = telemetry.esc_error_log_stamp[i];
+        this->FillEscDataLog(telemetry, i, esc.data_log);
+        esc.data_log_stamp = telemetry.esc_data_log_stamp[i];
+        this->FillEscResistance(telemetry, i, esc.resistance);
+        esc.resistance_stamp = telemetry.esc_resistance_stamp[i];
+    }
 
-    //turn on predefinned effect
-    led_control_->LedsSwitchPredefinedEffect(true);
+    powerboard_state_pub_.publish(msg);
+}
 
-    res.success = true;
+bool Control::CallbackEscErrorLog(ae_powerboard_control::GetEscErrorLog::Request &req, ae_powerboard_control::GetEscErrorLog::Response &res)
+{
+    uint8_t esc_mask = this->RequestedEscMask(req.esc_numbers);
+    this->RefreshEsc(TELEMETRY_ERROR_LOG, esc_mask, req.max_age, req.force_refresh);
+    this->FillEscErrorLog(telemetry_.Read(), esc_mask, res.error_log);
     return true;
 }
 
-bool Control::CallbackEscDeviceInfo(ae_powerboard_control::GetEscDeviceInfo::Request &req, ae_powerboard_control::GetEscDeviceInfo::Response &res)
+void Control::FillEscErrorLog(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscErrorLog> &error_logs)
 {
-    for(uint8_t i = 0; i < 4; i++)
-    {
-        ae_powerboard_control::EscDeviceInfo dev_info;
-        dev_info.esc_number = esc1 + i;
-        dev_info.hw_build = esc_device_info_[i].hw_build;
-        dev_info.serial_number = esc_device_info_[i].serial_number;
-        dev_info.diagnostic_status = esc_device_info_[i].Diagnostic_status;
-        dev_info.address = esc_device_info_[i].device_address;
-        dev_info.test = esc_device_info_[i].hw_build & 0x01;
-        dev_info.fw_version.high = esc_device_info_[i].fw_number.major;
-        dev_info.fw_version.mid = esc_device_info_[i].fw_number.mid;
-        dev_info.fw_version.low = esc_device_info_[i].fw_number.minor;
-        dev_info.valid = esc_device_info_status_ & (1 << i);
-        res.devices_info.push_back(dev_info);
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        if(!(esc_mask & (1 << i)))
+        {
+            continue;
+        }
+        error_logs.push_back(ae_powerboard_control::EscErrorLog());
+        this->FillEscErrorLog(telemetry, i, error_logs.back());
     }
-    return true;
 }
 
-bool Control::CallbackBoardDeviceInfo(ae_powerboard_control::GetBoardDeviceInfo::Request &req, ae_powerboard_control::GetBoardDeviceInfo::Response &res)
+void Control::FillEscErrorLog(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscErrorLog &error_log)
 {
-    ae_powerboard_control::BoardDeviceInfo dev_info;
-    dev_info.hw_build = board_device_info_.hw_build;
-    dev_info.serial_number = board_device_info_.serial_number;
-    dev_info.test = board_device_info_.hw_build & 0x01;
-    dev_info.fw_version.high = board_device_info_.fw_number.major;
-    dev_info.fw_version.mid = board_device_info_.fw_number.mid;
-    dev_info.fw_version.low = board_device_info_.fw_number.minor;
-    dev_info.valid = board_device_info_status_;
-    res.device_info = dev_info;
+    error_log.esc_number = esc1 + i;
+    error_log.diagnostic_status = telemetry.esc_error_log[i].Diagnostic_status;
+    error_log.valid = telemetry.esc_error_log_status & (1 << i);
+    error_log.last.error = telemetry.esc_error_log[i].Last.Error;
+    error_log.last.warning = telemetry.esc_error_log[i].Last.Warn;
+    error_log.previous.error = telemetry.esc_error_log[i].Prev.Error;
+    error_log.previous.warning = telemetry.esc_error_log[i].Prev.Warn;
+    error_log.all.error = telemetry.esc_error_log[i].All.Error;
+    error_log.all.warning = telemetry.esc_error_log[i].All.Warn;
+}
 
+bool Control::CallbackEscDataLog(ae_powerboard_control::GetEscDataLog::Request &req, ae_powerboard_control::GetEscDataLog::Response &res)
+{
+    uint8_t esc_mask = this->RequestedEscMask(req.esc_numbers);
+    this->RefreshEsc(TELEMETRY_DATA_LOG, esc_mask, req.max_age, req.force_refresh);
+    this->FillEscDataLog(telemetry_.Read(), esc_mask, res.data_log);
     return true;
 }
 
-bool Control::CallbackEscErrorLog(ae_powerboard_control::GetEscErrorLog::Request &req, ae_powerboard_control::GetEscErrorLog::Response &res)
+void Control::FillEscDataLog(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscDataLog> &data_logs)
 {
-    for(uint8_t i = 0; i < 4; i++)
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
     {
-        ae_powerboard_control::EscErrorLog error_log;
-        error_log.esc_number = esc1 + i;
-        error_log.diagnostic_status = esc_error_log_[i].Diagnostic_status;
-        error_log.valid = esc_error_log_status_ & (1 << i);
-        error_log.last.error = esc_error_log_[i].Last.Error;
-        error_log.last.warning = esc_error_log_[i].Last.Warn;
-        error_log.previous.error = esc_error_log_[i].Prev.Error;
-        error_log.previous.warning = esc_error_log_[i].Prev.Warn;
-        error_log.all.error = esc_error_log_[i].All.Error;
-        error_log.all.warning = esc_error_log_[i].All.Warn;
-        res.error_log.push_back(error_log);
+        if(!(esc_mask & (1 << i)))
+        {
+            continue;
+        }
+        data_logs.push_back(ae_powerboard_control::EscDataLog());
+        this->FillEscDataLog(telemetry, i, data_logs.back());
     }
-    return true;
 }
 
-bool Control::CallbackEscDataLog(ae_powerboard_control::GetEscDataLog::Request &req, ae_powerboard_control::GetEscDataLog::Response &res)
+void Control::FillEscDataLog(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscDataLog &data_log)
 {
-    for(uint8_t i = 0; i < 4; i++)
-    {
-        ae_powerboard_control::EscDataLog data_log;
-        data_log.esc_number = esc1 + i;
-        data_log.diagnostic_status = esc_data_log_[i].Diagnostic_status;
-        data_log.valid = esc_data_log_status_ & (1 << i);
-        data_log.motor_max_is = Utils::ConvertFixedToFloat(esc_data_log_[i].Is_Motor_Max, Utils::I4Q8, 0);
-        data_log.motor_avg_is = esc_data_log_[i].Is_Motor_Avg * 0.1f;
-        data_log.motor_max_temp = esc_data_log_[i].Temp_Motor_Max - 50;
-        data_log.esc_max_temp = esc_data_log_[i].Temp_ESC_Max - 50;
-        res.data_log.push_back(data_log);
-    }
-    return true;
+    Utils::EscDataValues values = Utils::ConvertDataLog(telemetry.esc_data_log[i]);
+
+    data_log.esc_number = esc1 + i;
+    data_log.diagnostic_status = telemetry.esc_data_log[i].Diagnostic_status;
+    data_log.valid = telemetry.esc_data_log_status & (1 << i);
+    data_log.motor_max_is = values.motor_max_is;
+    data_log.motor_avg_is = values.motor_avg_is;
+    data_log.motor_max_temp = values.motor_max_temp;
+    data_log.esc_max_temp = values.esc_max_temp;
 }
 
 bool Control::CallbackEscResistance(ae_powerboard_control::GetEscResistance::Request &req, ae_powerboard_control::GetEscResistance::Response &res)
 {
-    for(uint8_t i = 0; i < 4; i++)
+    uint8_t esc_mask = this->RequestedEscMask(req.esc_numbers);
+    this->RefreshEsc(TELEMETRY_RESISTANCE, esc_mask, req.max_age, req.force_refresh);
+    this->FillEscResistance(telemetry_.Read(), esc_mask, res.resistance);
+    return true;
+}
+
+void Control::FillEscResistance(const TelemetrySnapshot &telemetry, uint8_t esc_mask, std::vector<ae_powerboard_control::EscResistance> &resistances)
+{
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
     {
-        ae_powerboard_control::EscResistance resistance;
-        resistance.esc_number = esc1 + i;
-        resistance.diagnostic_status = esc_data_log_[i].Diagnostic_status;
-        resistance.valid = esc_restistance_status_ & (1 << i);
-        resistance.phase_a = esc_resistance_[i].Phase[0];
-        resistance.phase_b = esc_resistance_[i].Phase[1];
-        resistance.phase_c = esc_resistance_[i].Phase[2];
-        resistance.global = esc_resistance_[i].Global;
-        res.resistance.push_back(resistance);
+        if(!(esc_mask & (1 << i)))
+        {
+            continue;
+        }
+        resistances.push_back(ae_powerboard_control::EscResistance());
+        this->FillEscResistance(telemetry, i, resistances.back());
     }
-    return true;
+}
+
+void Control::FillEscResistance(const TelemetrySnapshot &telemetry, uint8_t i, ae_powerboard_control::EscResistance &resistance)
+{
+    resistance.esc_number = esc1 + i;
+    resistance.diagnostic_status = telemetry.esc_resistance[i].Diagnostic_status;
+    resistance.valid = telemetry.esc_resistance_status & (1 << i);
+    resistance.phase_a = telemetry.esc_resistance[i].Phase[0];
+    resistance.phase_b = telemetry.esc_resistance[i].Phase[1];
+    resistance.phase_c = telemetry.esc_resistance[i].Phase[2];
+    resistance.global = telemetry.esc_resistance[i].Global;
 }
 
 void Control::OpenI2C()
 {
+    //backend is selected by ~backend param or by port argument
+    std::string backend;
+    private_nh_.param<std::string>("backend", backend, (i2c_port_ == SIMULATED_PORT) ? "simulated" : "hardware");
+
+    if(backend == "simulated")
+    {
+        ROS_WARN("Simulated power board backend is used");
+        bus_.SetBackend(new SimulatedBackend(SimulatedBackend::ReadConfig(private_nh_)));
+    }
+    else
+    {
+        bus_.SetBackend(new HardwareBackend());
+    }
 
-    i2c_error_ = i2c_driver_.I2cOpen(i2c_port_.c_str());
+    i2c_error_ = bus_.Open(i2c_port_);
 
     if(i2c_error_)
     {
@@ -495,7 +1491,6 @@ void Control::GetAll()
 
 void Control::GetEscErrorLog()
 {
-    esc_error_log_status_ = 0x00;
     if(i2c_error_)
     {
         return;
@@ -503,150 +1498,356 @@ void Control::GetEscErrorLog()
 
     for (uint8_t i = 0; i < 4; i++)
     {
-        ERROR_WARN_LOG er_log = ERROR_WARN_LOG_INIT;
-        uint8_t status = drone_control_->EscGetErrorLogs(&er_log, (esc1 + i));
-        if(status)
-        {
-            ROS_ERROR("ESC%d ERROR LOG - problem reading data", (esc1 + i));
-        }
-        else
-        {
-            ROS_INFO("ESC%d ERROR LOG - Status: %u, Last E: 0x%x W: 0x%x, Prev E: 0x%x W: 0x%x, All E: 0x%x W: 0x%x", (esc1 + i),  
-                er_log.Diagnostic_status, er_log.Last.Error, er_log.Last.Warn, er_log.Prev.Error, er_log.Prev.Warn,
-                er_log.All.Error, er_log.All.Warn);
-            esc_error_log_[i] = er_log;
-            esc_error_log_status_ |= (1 << i);
-        }
+        this->ReadEscErrorLog(i, true);
     }
 }
 
 void Control::GetEscDataLog()
 {
-    esc_data_log_status_ = 0x00;
     if(i2c_error_)
     {
         return;
     }
 
-    for (int i = 0; i < 4; i++)
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        this->ReadEscDataLog(i, true);
+    }
+}
+
+void Control::GetEscResistance()
+{
+    if(i2c_error_)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        this->ReadEscResistance(i, true);
+    }
+}
+
+void Control::GetEscDeviceInfo()
+{
+    if(i2c_error_)
+    {
+        return;
+    }
+
+    for(uint8_t i = 0; i< 4; i++)
+    {
+        this->ReadEscDeviceInfo(i, true);
+    }
+}
+
+bool Control::ReadEscErrorLog(uint8_t i, bool verbose)
+{
+    ERROR_WARN_LOG er_log = ERROR_WARN_LOG_INIT;
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_TELEMETRY, [&](PowerboardBackend &board) -> uint8_t
     {
-        RUN_DATA_Struct data_log;
-        uint8_t status = drone_control_->EscGetDataLogs(&data_log, (esc1 + i)); 
+        uint8_t status = board.EscGetErrorLogs(&er_log, (esc1 + i));
+        TelemetrySnapshot &telemetry = telemetry_.Edit();
         if(status)
         {
-            ROS_ERROR("ESC%d DATA - problem reading data", (esc1 + i));
-        } 
+            telemetry.esc_error_log_status &= ~(1 << i);
+        }
         else
         {
-            ROS_INFO("ESC%d DATA - Status: %d, Is_max: %f, Is_avg: %f, Esc_temp_max: %d, Motor_temp_max: %d", (esc1 + i),
-                data_log.Diagnostic_status, Utils::ConvertFixedToFloat(data_log.Is_Motor_Max, Utils::I4Q8, 0), 
-                data_log.Is_Motor_Avg * 0.1f, data_log.Temp_ESC_Max - 50, data_log.Temp_Motor_Max - 50);
-            esc_data_log_[i] = data_log;
-            esc_data_log_status_ |= (1 << i);
+            //last successfully read log, fault events are diffed against it
+            ERROR_WARN_LOG previous = telemetry.esc_error_log[i];
+            ros::Time stamp = ros::Time::now();
+            telemetry.esc_error_log[i] = er_log;
+            telemetry.esc_error_log_status |= (1 << i);
+            telemetry.esc_error_log_stamp[i] = stamp;
+
+            FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_ESC_ERROR_LOG, stamp.toNSec());
+            record.esc_number = esc1 + i;
+            record.status = er_log.Diagnostic_status;
+            record.payload.error_log.last_error = er_log.Last.Error;
+            record.payload.error_log.last_warning = er_log.Last.Warn;
+            record.payload.error_log.previous_error = er_log.Prev.Error;
+            record.payload.error_log.previous_warning = er_log.Prev.Warn;
+            record.payload.error_log.all_error = er_log.All.Error;
+            record.payload.error_log.all_warning = er_log.All.Warn;
+            recorder_.RecordChange(record, recorded_esc_error_log_[i]);
+
+            //published on bus thread, events of timer and refresh reads go out in order of capture
+            this->PublishFaultEvents(i, previous, er_log, stamp);
         }
+        telemetry_.Publish();
+        return status;
+    });
+    if(status)
+    {
+        ROS_ERROR_THROTTLE((verbose ? 0 : 10), "ESC%d ERROR LOG - problem reading data", (esc1 + i));
+        return false;
+    }
+
+    if(verbose)
+    {
+        ROS_INFO("ESC%d ERROR LOG - Status: %u, Last E: 0x%x W: 0x%x, Prev E: 0x%x W: 0x%x, All E: 0x%x W: 0x%x", (esc1 + i),
+            er_log.Diagnostic_status, er_log.Last.Error, er_log.Last.Warn, er_log.Prev.Error, er_log.Prev.Warn,
+            er_log.All.Error, er_log.All.Warn);
     }
+    return true;
 }
 
-void Control::GetEscResistance()
+void Control::PublishFaultEvents(uint8_t i, const ERROR_WARN_LOG &previous, const ERROR_WARN_LOG &current, const ros::Time &stamp)
 {
-    esc_restistance_status_ = 0x00;
-    if(i2c_error_)
+    ae_powerboard_control::EscFaultEvents::Ptr msg = boost::make_shared<ae_powerboard_control::EscFaultEvents>();
+    AppendFaultEvents(msg->events, ae_powerboard_control::EscFaultEvent::LOG_LAST, false, previous.Last.Error, current.Last.Error);
+    AppendFaultEvents(msg->events, ae_powerboard_control::EscFaultEvent::LOG_LAST, true, previous.Last.Warn, current.Last.Warn);
+    AppendFaultEvents(msg->events, ae_powerboard_control::EscFaultEvent::LOG_PREVIOUS, false, previous.Prev.Error, current.Prev.Error);
+    AppendFaultEvents(msg->events, ae_powerboard_control::EscFaultEvent::LOG_PREVIOUS, true, previous.Prev.Warn, current.Prev.Warn);
+    AppendFaultEvents(msg->events, ae_powerboard_control::EscFaultEvent::LOG_ALL, false, previous.All.Error, current.All.Error);
+    AppendFaultEvents(msg->events, ae_powerboard_control::EscFaultEvent::LOG_ALL, true, previous.All.Warn, current.All.Warn);
+
+    //nothing changed, nothing sent
+    if(msg->events.empty())
     {
         return;
     }
 
-    for (int i = 0; i < 4; i++)
+    msg->stamp = stamp;
+    msg->esc_number = esc1 + i;
+    esc_fault_events_pub_.publish(msg);
+}
+
+void Control::AppendFaultEvents(std::vector<ae_powerboard_control::EscFaultEvent> &events, uint8_t log, bool warning, uint32_t previous, uint32_t current)
+{
+    uint32_t changed = previous ^ current;
+    while(changed)
+    {
+        uint32_t bit = changed & (~changed + 1);
+        changed &= changed - 1;
+
+        ae_powerboard_control::EscFaultEvent event;
+        event.log = log;
+        event.warning = warning;
+        event.bit = bit;
+        event.raised = (current & bit) != 0;
+        events.push_back(event);
+    }
+}
+
+bool Control::ReadEscDataLog(uint8_t i, bool verbose)
+{
+    RUN_DATA_Struct data_log;
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_TELEMETRY, [&](PowerboardBackend &board) -> uint8_t
     {
-        RESISTANCE_STRUCT res;
-        uint8_t status = drone_control_->EscGetResistance(&res, (esc1 + i)); 
+        uint8_t status = board.EscGetDataLogs(&data_log, (esc1 + i));
+        TelemetrySnapshot &telemetry = telemetry_.Edit();
         if(status)
         {
-            ROS_ERROR("ESC%d RESISTANCE - problem reading data", (esc1 + i));
-        } 
+            telemetry.esc_data_log_status &= ~(1 << i);
+        }
         else
         {
-            ROS_INFO("ESC%d RESISTANCE - Status: %d, Ph A: %.6f, Ph B: %.6f, Ph C: %.6f, Rs: %.6f", (esc1 + i),
-                res.Diagnostic_status, res.Phase[0], res.Phase[1], res.Phase[2], res.Global);
-            esc_resistance_[i] = res;
-            esc_restistance_status_ |= (1 << i);
+            telemetry.esc_data_log[i] = data_log;
+            telemetry.esc_data_log_status |= (1 << i);
+            telemetry.esc_data_log_stamp[i] = ros::Time::now();
+
+            FlightRecord record = FlightRecorder::Make(FLIGHT_RECORD_ESC_DATA_LOG, telemetry.esc_data_log_stamp[i].toNSec());
+            record.esc_number = esc1 + i;
+            record.status = data_log.Diagnostic_status;
+            Utils::EscDataValues values = Utils::ConvertDataLog(data_log);
+            record.payload.data_log.motor_max_is = values.motor_max_is;
+            record.payload.data_log.motor_avg_is = values.motor_avg_is;
+            record.payload.data_log.motor_max_temp = values.motor_max_temp;
+            record.payload.data_log.esc_max_temp = values.esc_max_temp;
+            recorder_.RecordChange(record, recorded_esc_data_log_[i]);
         }
+        telemetry_.Publish();
+        return status;
+    });
+    if(status)
+    {
+        ROS_ERROR_THROTTLE((verbose ? 0 : 10), "ESC%d DATA - problem reading data", (esc1 + i));
+        return false;
+    }
+
+    if(verbose)
+    {
+        ROS_INFO("ESC%d DATA - Status: %d, Is_max: %f, Is_avg: %f, Esc_temp_max: %d, Motor_temp_max: %d", (esc1 + i),
+            data_log.Diagnostic_status, Utils::MotorCurrent::ToFloat(data_log.Is_Motor_Max),
+            data_log.Is_Motor_Avg * 0.1f, data_log.Temp_ESC_Max - 50, data_log.Temp_Motor_Max - 50);
     }
+    return true;
 }
 
-void Control::GetEscDeviceInfo()
+bool Control::ReadEscResistance(uint8_t i, bool verbose)
 {
-    esc_device_info_status_ = 0x00;
-    if(i2c_error_)
+    RESISTANCE_STRUCT res;
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_TELEMETRY, [&](PowerboardBackend &board) -> uint8_t
     {
-        return;
+        uint8_t status = board.EscGetResistance(&res, (esc1 + i));
+        TelemetrySnapshot &telemetry = telemetry_.Edit();
+        if(status)
+        {
+            telemetry.esc_resistance_status &= ~(1 << i);
+        }
+        else
+        {
+            telemetry.esc_resistance[i] = res;
+            telemetry.esc_resistance_status |= (1 << i);
+            telemetry.esc_resistance_stamp[i] = ros::Time::now();
+        }
+        telemetry_.Publish();
+        return status;
+    });
+    if(status)
+    {
+        ROS_ERROR_THROTTLE((verbose ? 0 : 10), "ESC%d RESISTANCE - problem reading data", (esc1 + i));
+        return false;
     }
 
-    for(uint8_t i = 0; i< 4; i++)
+    if(verbose)
+    {
+        ROS_INFO("ESC%d RESISTANCE - Status: %d, Ph A: %.6f, Ph B: %.6f, Ph C: %.6f, Rs: %.6f", (esc1 + i),
+            res.Diagnostic_status, res.Phase[0], res.Phase[1], res.Phase[2], res.Global);
+    }
+    return true;
+}
+
+bool Control::ReadEscDeviceInfo(uint8_t i, bool verbose)
+{
+    ADB_DEVICE_INFO dev_info;
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_TELEMETRY, [&](PowerboardBackend &board) -> uint8_t
     {
-        ADB_DEVICE_INFO dev_info;
-        if(drone_control_->EscGetDeviceInfo(&dev_info, (esc1 + i)))
+        uint8_t status = board.EscGetDeviceInfo(&dev_info, (esc1 + i));
+        TelemetrySnapshot &telemetry = telemetry_.Edit();
+        if(status)
         {
-            ROS_INFO("ESC%d INFO - problem reading data", (esc1 + i));
+            telemetry.esc_device_info_status &= ~(1 << i);
         }
         else
         {
-            ROS_INFO("ESC%d INFO - Status: %u, Fw: %u.%u.%u, Address: %u, Hw build: %u, Sn: %u", (esc1 + i), dev_info.Diagnostic_status,
-                dev_info.fw_number.major, dev_info.fw_number.mid, dev_info.fw_number.minor, dev_info.device_address,
-                dev_info.hw_build, dev_info.serial_number);
-            esc_device_info_[i] = dev_info;
-            esc_device_info_status_ |= (1 << i);
+            telemetry.esc_device_info[i] = dev_info;
+            telemetry.esc_device_info_status |= (1 << i);
+            telemetry.esc_device_info_stamp[i] = ros::Time::now();
         }
+        telemetry_.Publish();
+        return status;
+    });
+    if(status)
+    {
+        ROS_INFO_THROTTLE((verbose ? 0 : 10), "ESC%d INFO - problem reading data", (esc1 + i));
+        return false;
     }
+
+    if(verbose)
+    {
+        ROS_INFO("ESC%d INFO - Status: %u, Fw: %u.%u.%u, Address: %u, Hw build: %u, Sn: %u", (esc1 + i), dev_info.Diagnostic_status,
+            dev_info.fw_number.major, dev_info.fw_number.mid, dev_info.fw_number.minor, dev_info.device_address,
+            dev_info.hw_build, dev_info.serial_number);
+    }
+    return true;
 }
 
 void Control::GetBoardDeviceInfo()
 {
-    board_device_info_status_ = false;
     if(i2c_error_)
     {
         return;
     }
-    
+
+    this->ReadBoardDeviceInfo(true);
+}
+
+bool Control::ReadBoardDeviceInfo(bool verbose)
+{
     POWER_BOARD_INFO dev_info;
-    if(drone_control_->PowerBoardInfoGet(&dev_info))
+    uint8_t status = bus_.Execute(BusExecutor::PRIORITY_TELEMETRY, [&](PowerboardBackend &board) -> uint8_t
     {
-        ROS_INFO("BOARD INFO - problem reading data");
+        uint8_t status = board.PowerBoardInfoGet(&dev_info);
+        TelemetrySnapshot &telemetry = telemetry_.Edit();
+        telemetry.board_device_info_status = !status;
+        if(!status)
+        {
+            telemetry.board_device_info = dev_info;
+            telemetry.board_device_info_stamp = ros::Time::now();
+        }
+        telemetry_.Publish();
+        return status;
+    });
+    if(status)
+    {
+        ROS_INFO_THROTTLE((verbose ? 0 : 10), "BOARD INFO - problem reading data");
+        return false;
     }
-    else
+
+    if(verbose)
     {
         ROS_INFO("BOARD INFO - Fw: %u.%u.%u, Hw build: %u, Sn: %u", dev_info.fw_number.major, dev_info.fw_number.mid, 
           dev_info.fw_number.minor, dev_info.hw_build, dev_info.serial_number);
-        board_device_info_ = dev_info;
-        board_device_info_status_ = true;
     }
+    return true;
 }
 
 void Control::CloseI2C()
 {
-    i2c_driver_.I2cClose();
+    bus_.Close();
 }
 
-int main(int argc, char **argv)
+std::vector<ControlBoard> Control::ReadBoards(const ros::NodeHandle &private_nh, const std::string &default_port)
 {
-    ros::init(argc, argv, "pb_control_node");
-    ros::NodeHandle n;
-    
-    std::string i2c_port = DEVICE_I2C_NANO;
+    std::vector<ControlBoard> boards;
 
-    if(argc >= 2)
+    //list of {name, port}, every board gets own bus thread, topics under its name and params in ~name
+    XmlRpc::XmlRpcValue items;
+    if(!private_nh.getParam("boards", items) || items.getType() != XmlRpc::XmlRpcValue::TypeArray)
     {
-        i2c_port = argv[1];
+        ControlBoard board;
+        board.port = default_port;
+        boards.push_back(board);
+        return boards;
     }
-    ROS_INFO("I2C address: %s", i2c_port.c_str());    
-       
-    Control control(n, i2c_port);
 
-    ros::AsyncSpinner spinner(4);
-    spinner.start();
+    for(int i = 0; i < items.size(); i++)
+    {
+        XmlRpc::XmlRpcValue &item = items[i];
+        if(item.getType() != XmlRpc::XmlRpcValue::TypeStruct || !item.hasMember("name") || !item.hasMember("port") ||
+           item["name"].getType() != XmlRpc::XmlRpcValue::TypeString || item["port"].getType() != XmlRpc::XmlRpcValue::TypeString)
+        {
+            ROS_WARN("Boards - boards item %d ignored, name and port are required", i);
+            continue;
+        }
 
-    ros::waitForShutdown();
+        ControlBoard board;
+        board.name = static_cast<std::string>(item["name"]);
+        board.port = static_cast<std::string>(item["port"]);
+        bool duplicate = board.name.empty();
+        for(size_t j = 0; j < boards.size(); j++)
+        {
+            duplicate = duplicate || (boards[j].name == board.name);
+        }
+        if(duplicate)
+        {
+            ROS_WARN("Boards - boards item %d ignored, name '%s' is empty or used", i, board.name.c_str());
+            continue;
+        }
+        boards.push_back(board);
+    }
+    return boards;
+}
 
-    spinner.stop();
+ros::NodeHandle Control::BoardNodeHandle(const ros::NodeHandle &nh, const ControlBoard &board)
+{
+    //relative to namespace of node or nodelet, so __ns and remapping apply, single board keeps original names
+    std::string ns = "ae_powerboard_control";
+    if(!board.name.empty())
+    {
+        ns += "/" + board.name;
+    }
+    return ros::NodeHandle(nh, ns);
+}
 
-    return 0;
-}
\ No newline at end of file
+ros::NodeHandle Control::BoardPrivateNodeHandle(const ros::NodeHandle &private_nh, const ControlBoard &board)
+{
+    if(board.name.empty())
+    {
+        return private_nh;
+    }
+    return ros::NodeHandle(private_nh, board.name);
+}
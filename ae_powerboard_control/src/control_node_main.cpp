@@ -0,0 +1,48 @@
+#include <memory>
+
+#include "control_node.hpp"
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "pb_control_node");
+    ros::NodeHandle n;
+    ros::NodeHandle private_n("~");
+    
+    std::string i2c_port = DEVICE_I2C_NANO;
+
+    if(argc >= 2)
+    {
+        i2c_port = argv[1];
+    }
+
+    //boards are independent, failed one does not stop others
+    std::vector<ControlBoard> boards = Control::ReadBoards(private_n, i2c_port);
+    std::vector<std::unique_ptr<Control>> controls;
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        ROS_INFO("Board '%s' - I2C address: %s", boards[i].name.c_str(), boards[i].port.c_str());
+        try
+        {
+            controls.emplace_back(new Control(Control::BoardNodeHandle(n, boards[i]), Control::BoardPrivateNodeHandle(private_n, boards[i]), boards[i].port, boards[i].name));
+        }
+        catch(const std::string &error)
+        {
+            ROS_ERROR("Board '%s' - %s", boards[i].name.c_str(), error.c_str());
+        }
+    }
+    if(controls.empty())
+    {
+        ROS_ERROR("No board is running");
+        return 1;
+    }
+
+    //service callbacks wait for bus, every board gets own share of threads
+    ros::AsyncSpinner spinner(4 * controls.size());
+    spinner.start();
+
+    ros::waitForShutdown();
+
+    spinner.stop();
+
+    return 0;
+}
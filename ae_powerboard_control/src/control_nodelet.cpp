@@ -0,0 +1,25 @@
+#include "control_nodelet.hpp"
+
+#include "pluginlib/class_list_macros.h"
+
+void ControlNodelet::onInit()
+{
+    std::string i2c_port;
+    this->getPrivateNodeHandle().param<std::string>("i2c_port", i2c_port, DEVICE_I2C_NANO);
+
+    std::vector<ControlBoard> boards = Control::ReadBoards(this->getPrivateNodeHandle(), i2c_port);
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        NODELET_INFO("Board '%s' - I2C address: %s", boards[i].name.c_str(), boards[i].port.c_str());
+        try
+        {
+            controls_.emplace_back(new Control(Control::BoardNodeHandle(this->getMTNodeHandle(), boards[i]), Control::BoardPrivateNodeHandle(this->getMTPrivateNodeHandle(), boards[i]), boards[i].port, boards[i].name));
+        }
+        catch(const std::string &error)
+        {
+            NODELET_ERROR("Board '%s' - %s", boards[i].name.c_str(), error.c_str());
+        }
+    }
+}
+
+PLUGINLIB_EXPORT_CLASS(ControlNodelet, nodelet::Nodelet)
@@ -4,8 +4,8 @@
 
 
 /*
-*  This example enables selected custom effect and starts handling of user-custom effects in main timer. User can write own effects
-*  and add handler to CallbackMainTimer. This effects are completelly handled from ROS. As example FLIGHT_MODE effect is writted in control_node.cpp
+*  This example enables selected custom effect and starts handling of user-custom effects in main timer. User can define own effects
+*  in config/led_effects.yaml (led_effects param). This effects are completelly handled from ROS. FLIGHT_MODE effect is built into led_effect.cpp
 *
 *  NOTE:    predefined effect is automatically disabled if custom effect is started. But there is possibility to control only additional LEDs channel 
             while predefined effect on front and rear channels is still running.
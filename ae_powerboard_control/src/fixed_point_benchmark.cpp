@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "utils.hpp"
+
+/*
+*  Conversion time of ESC motor current by runtime ConvertFixedToFloat against compile time
+*  FixedPoint, single and batch, and of whole data log array by ConvertDataLogs.
+*
+*  usage: fixed_point_benchmark [numbers] [rounds]
+*/
+
+#define BENCHMARK_ESC_COUNT 4
+
+typedef std::chrono::steady_clock Clock;
+
+//keeps results alive, so conversions are not optimized out
+static volatile float sink;
+
+static double ElapsedNs(const Clock::time_point &start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+static void PrintResult(const char *converter, uint64_t conversions, double elapsed_ns, float checksum)
+{
+    printf("%-20s %12lu %12.3f %16.3f\n", converter, (unsigned long)conversions, elapsed_ns / conversions, checksum);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = (argc >= 2) ? atoi(argv[1]) : 4096;
+    uint32_t rounds = (argc >= 3) ? atoi(argv[2]) : 1000;
+
+    if(count == 0 || rounds == 0)
+    {
+        fprintf(stderr, "usage: %s [numbers] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    //every I4Q8 value, repeated
+    std::vector<uint32_t> numbers(count);
+    std::vector<float> results(count);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        numbers[i] = i & 0xfff;
+    }
+    uint64_t conversions = (uint64_t)count * rounds;
+
+    printf("%u numbers, %u rounds\n", count, rounds);
+    printf("%-20s %12s %12s %16s\n", "converter", "conversions", "ns/value", "checksum");
+
+    {
+        float checksum = 0.0f;
+        Clock::time_point start = Clock::now();
+        for(uint32_t r = 0; r < rounds; r++)
+        {
+            for(uint32_t i = 0; i < count; i++)
+            {
+                results[i] = Utils::ConvertFixedToFloat(numbers[i], Utils::I4Q8, 0);
+            }
+            checksum += results[r % count];
+        }
+        PrintResult("runtime", conversions, ElapsedNs(start), checksum);
+        sink = checksum;
+    }
+    {
+        float checksum = 0.0f;
+        Clock::time_point start = Clock::now();
+        for(uint32_t r = 0; r < rounds; r++)
+        {
+            for(uint32_t i = 0; i < count; i++)
+            {
+                results[i] = Utils::MotorCurrent::ToFloat(numbers[i]);
+            }
+            checksum += results[r % count];
+        }
+        PrintResult("fixed_point", conversions, ElapsedNs(start), checksum);
+        sink = checksum;
+    }
+    {
+        float checksum = 0.0f;
+        Clock::time_point start = Clock::now();
+        for(uint32_t r = 0; r < rounds; r++)
+        {
+            Utils::MotorCurrent::ToFloat(numbers.data(), results.data(), count);
+            checksum += results[r % count];
+        }
+        PrintResult("fixed_point_batch", conversions, ElapsedNs(start), checksum);
+        sink = checksum;
+    }
+    {
+        //data logs of all ESCs as read by GetEscDataLog
+        RUN_DATA_Struct data_logs[BENCHMARK_ESC_COUNT];
+        Utils::EscDataValues values[BENCHMARK_ESC_COUNT];
+        memset(data_logs, 0, sizeof(data_logs));
+        float checksum = 0.0f;
+        Clock::time_point start = Clock::now();
+        for(uint64_t r = 0; r < conversions / BENCHMARK_ESC_COUNT; r++)
+        {
+            for(uint8_t i = 0; i < BENCHMARK_ESC_COUNT; i++)
+            {
+                data_logs[i].Is_Motor_Max = numbers[(r * BENCHMARK_ESC_COUNT + i) % count];
+            }
+            Utils::ConvertDataLogs(data_logs, values);
+            checksum += values[r % BENCHMARK_ESC_COUNT].motor_max_is;
+        }
+        PrintResult("data_logs", conversions / BENCHMARK_ESC_COUNT * BENCHMARK_ESC_COUNT, ElapsedNs(start), checksum);
+        sink = checksum;
+    }
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "flight_recorder.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <mutex>
+#include <set>
+
+//open recorders of all boards in process, guarded by mutex so none is unmapped while flushed
+static std::mutex open_recorders_mutex;
+static std::set<FlightRecorder*> open_recorders;
+
+FlightRecorder::FlightRecorder()
+    :fd_(-1),
+     map_(NULL),
+     map_size_(0),
+     header_(NULL),
+     records_(NULL),
+     capacity_(0),
+     head_(0)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    this->Close();
+}
+
+bool FlightRecorder::Open(const std::string &path, uint64_t capacity)
+{
+    this->Close();
+    if(capacity == 0)
+    {
+        return true;
+    }
+
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd_ < 0)
+    {
+        return true;
+    }
+
+    map_size_ = sizeof(FlightRecorderHeader) + capacity * sizeof(FlightRecord);
+
+    //keep previous content only when layout matches
+    FlightRecorderHeader existing;
+    struct stat file_stat;
+    bool resume = (fstat(fd_, &file_stat) == 0) && ((size_t)file_stat.st_size == map_size_) &&
+        (pread(fd_, &existing, sizeof(existing), 0) == sizeof(existing)) &&
+        (memcmp(existing.magic, FLIGHT_RECORDER_MAGIC, sizeof(existing.magic)) == 0) &&
+        (existing.version == FLIGHT_RECORDER_VERSION) && (existing.record_size == sizeof(FlightRecord)) &&
+        (existing.capacity == capacity);
+
+    if(!resume && (ftruncate(fd_, 0) != 0 || ftruncate(fd_, map_size_) != 0))
+    {
+        this->Close();
+        return true;
+    }
+
+    void *map = mmap(NULL, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if(map == MAP_FAILED)
+    {
+        this->Close();
+        return true;
+    }
+
+    map_ = (uint8_t*)map;
+    header_ = (FlightRecorderHeader*)map_;
+    records_ = (FlightRecord*)(map_ + sizeof(FlightRecorderHeader));
+    capacity_ = capacity;
+
+    uint64_t head = 0;
+    if(resume)
+    {
+        //header head may lag behind records, take newest complete record
+        head = header_->head;
+        for(uint64_t i = 0; i < capacity_; i++)
+        {
+            if(records_[i].sequence > head)
+            {
+                head = records_[i].sequence;
+            }
+        }
+    }
+    else
+    {
+        memset(header_, 0, sizeof(FlightRecorderHeader));
+        memcpy(header_->magic, FLIGHT_RECORDER_MAGIC, sizeof(header_->magic));
+        header_->version = FLIGHT_RECORDER_VERSION;
+        header_->record_size = sizeof(FlightRecord);
+        header_->capacity = capacity_;
+    }
+    header_->head = head;
+    head_.store(head, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(open_recorders_mutex);
+    open_recorders.insert(this);
+    return false;
+}
+
+void FlightRecorder::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(open_recorders_mutex);
+        open_recorders.erase(this);
+    }
+    if(map_)
+    {
+        this->Flush();
+        munmap(map_, map_size_);
+    }
+    if(fd_ >= 0)
+    {
+        close(fd_);
+    }
+
+    fd_ = -1;
+    map_ = NULL;
+    map_size_ = 0;
+    header_ = NULL;
+    records_ = NULL;
+    capacity_ = 0;
+}
+
+bool FlightRecorder::IsOpen() const
+{
+    return map_ != NULL;
+}
+
+void FlightRecorder::Flush()
+{
+    if(!map_)
+    {
+        return;
+    }
+    msync(map_, map_size_, MS_SYNC);
+}
+
+void FlightRecorder::FlushAll()
+{
+    std::lock_guard<std::mutex> lock(open_recorders_mutex);
+    for(std::set<FlightRecorder*>::iterator it = open_recorders.begin(); it != open_recorders.end(); ++it)
+    {
+        (*it)->Flush();
+    }
+}
+
+void FlightRecorder::Record(FlightRecord &record)
+{
+    if(!map_)
+    {
+        return;
+    }
+
+    uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    FlightRecord &slot = records_[index % capacity_];
+
+    //invalidate slot, write body, then mark complete
+    __atomic_store_n(&slot.sequence, 0, __ATOMIC_RELAXED);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.sequence = 0;
+    memcpy(((uint8_t*)&slot) + sizeof(slot.sequence), ((uint8_t*)&record) + sizeof(record.sequence),
+        sizeof(FlightRecord) - sizeof(record.sequence));
+    record.sequence = index + 1;
+    __atomic_store_n(&slot.sequence, index + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&header_->head, index + 1, __ATOMIC_RELAXED);
+}
+
+void FlightRecorder::RecordChange(FlightRecord &record, FlightRecord &last)
+{
+    //compare everything after sequence and stamp
+    size_t offset = sizeof(record.sequence) + sizeof(record.stamp_ns);
+    if(memcmp(((uint8_t*)&last) + offset, ((uint8_t*)&record) + offset, sizeof(FlightRecord) - offset) == 0)
+    {
+        return;
+    }
+
+    this->Record(record);
+    last = record;
+}
+
+FlightRecord FlightRecorder::Make(uint8_t type, int64_t stamp_ns)
+{
+    FlightRecord record;
+    memset(&record, 0, sizeof(record));
+    record.type = type;
+    record.stamp_ns = stamp_ns;
+    return record;
+}
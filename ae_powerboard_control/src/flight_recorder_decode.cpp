@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "flight_recorder.hpp"
+
+/*
+*  Offline decoder of flight recorder file, prints complete records from oldest to newest.
+*  Usage: flight_recorder_decode <file>
+*/
+
+bool CompareSequence(const FlightRecord &a, const FlightRecord &b)
+{
+    return a.sequence < b.sequence;
+}
+
+const char *LedCommandName(uint8_t command)
+{
+    switch(command)
+    {
+        case FLIGHT_LED_COLOR:
+            return "color";
+        case FLIGHT_LED_CUSTOM_COLOR:
+            return "custom_color";
+        case FLIGHT_LED_CUSTOM_EFFECT:
+            return "custom_effect";
+        case FLIGHT_LED_PREDEFINED_EFFECT:
+            return "predefined_effect";
+        default:
+            return "unknown";
+    }
+}
+
+void PrintRecord(const FlightRecord &record)
+{
+    printf("%" PRIu64 " %" PRId64 ".%09" PRId64 " ", record.sequence, record.stamp_ns / 1000000000, record.stamp_ns % 1000000000);
+
+    switch(record.type)
+    {
+        case FLIGHT_RECORD_SESSION:
+            printf("SESSION\n");
+            break;
+        case FLIGHT_RECORD_ESC_ERROR_LOG:
+        {
+            const FlightEscErrorLog &log = record.payload.error_log;
+            printf("ESC%u ERROR LOG status: %u, Last E: 0x%x W: 0x%x, Prev E: 0x%x W: 0x%x, All E: 0x%x W: 0x%x\n",
+                record.esc_number, record.status, log.last_error, log.last_warning, log.previous_error, log.previous_warning,
+                log.all_error, log.all_warning);
+            break;
+        }
+        case FLIGHT_RECORD_ESC_DATA_LOG:
+        {
+            const FlightEscDataLog &log = record.payload.data_log;
+            printf("ESC%u DATA status: %u, Is_max: %f, Is_avg: %f, Esc_temp_max: %d, Motor_temp_max: %d\n",
+                record.esc_number, record.status, log.motor_max_is, log.motor_avg_is, log.esc_max_temp, log.motor_max_temp);
+            break;
+        }
+        case FLIGHT_RECORD_BOARD_STATUS:
+            printf("BOARD STATUS %u\n", record.status);
+            break;
+        case FLIGHT_RECORD_LED_COMMAND:
+        {
+            const FlightLedCommand &led = record.payload.led;
+            printf("LED %s mask: 0x%02x, effect: %u, count: %u %u %u %u %u, colors:", LedCommandName(led.command), led.mask,
+                led.effect_type, led.count[0], led.count[1], led.count[2], led.count[3], led.count[4]);
+            for(uint8_t i = 0; i < 4; i++)
+            {
+                printf(" {%u, %u, %u}", led.color[i][0], led.color[i][1], led.color[i][2]);
+            }
+            printf("\n");
+            break;
+        }
+        default:
+            printf("UNKNOWN type %u\n", record.type);
+            break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <file>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if(!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    FlightRecorderHeader header;
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, FLIGHT_RECORDER_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != FLIGHT_RECORDER_VERSION || header.record_size != sizeof(FlightRecord))
+    {
+        fprintf(stderr, "%s is not flight recorder file of version %u\n", argv[1], FLIGHT_RECORDER_VERSION);
+        fclose(file);
+        return 1;
+    }
+
+    //skip empty and torn records
+    std::vector<FlightRecord> records;
+    FlightRecord record;
+    for(uint64_t i = 0; i < header.capacity && fread(&record, sizeof(record), 1, file) == 1; i++)
+    {
+        if(record.sequence != 0)
+        {
+            records.push_back(record);
+        }
+    }
+    fclose(file);
+
+    std::sort(records.begin(), records.end(), CompareSequence);
+    for(size_t i = 0; i < records.size(); i++)
+    {
+        PrintRecord(records[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include "led_compositor.hpp"
+
+#include <algorithm>
+
+LedCompositor::LedCompositor()
+{
+    for(uint8_t l = 0; l < LED_LAYER_COUNT; l++)
+    {
+        layers_[l].mask = 0;
+        layers_[l].blend = LED_BLEND_REPLACE;
+    }
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        composed_count_[ch] = 0;
+    }
+}
+
+void LedCompositor::Reserve(uint16_t count)
+{
+    for(uint8_t l = 0; l < LED_LAYER_COUNT; l++)
+    {
+        for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+        {
+            layers_[l].colors[ch].reserve(count);
+        }
+    }
+    output_.Reserve(count);
+}
+
+bool LedCompositor::Claim(uint8_t layer, const std::string &owner)
+{
+    //anonymous claim would block nobody
+    Layer &target = layers_[layer];
+    if(owner.empty() || (!target.owner.empty() && target.owner != owner))
+    {
+        return true;
+    }
+    target.owner = owner;
+    return false;
+}
+
+void LedCompositor::Release(uint8_t layer)
+{
+    layers_[layer].owner.clear();
+}
+
+uint8_t LedCompositor::Set(uint8_t layer, const LedFrame &frame, uint8_t blend)
+{
+    Layer &target = layers_[layer];
+    uint8_t dirty = frame.mask;
+    if(blend != target.blend)
+    {
+        //channels kept from before are blended differently too
+        dirty |= target.mask;
+        target.blend = blend;
+    }
+
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if(frame.mask & LED_CHANNEL_MASK(ch))
+        {
+            target.colors[ch].assign(frame.colors[ch].begin(), frame.colors[ch].end());
+        }
+    }
+    target.mask |= frame.mask;
+    return dirty;
+}
+
+uint8_t LedCompositor::Clear(uint8_t layer, uint8_t mask)
+{
+    Layer &target = layers_[layer];
+    uint8_t dirty = target.mask & mask;
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if(dirty & LED_CHANNEL_MASK(ch))
+        {
+            target.colors[ch].clear();
+        }
+    }
+    target.mask &= ~mask;
+    return dirty;
+}
+
+uint8_t LedCompositor::Mask() const
+{
+    uint8_t mask = 0;
+    for(uint8_t l = 0; l < LED_LAYER_COUNT; l++)
+    {
+        mask |= layers_[l].mask;
+    }
+    return mask;
+}
+
+const LedFrame &LedCompositor::Compose(uint8_t mask, bool update_count)
+{
+    output_.mask = 0;
+    output_.update_count = update_count;
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if(!(mask & LED_CHANNEL_MASK(ch)))
+        {
+            continue;
+        }
+
+        std::vector<COLOR> &result = output_.colors[ch];
+        result.clear();
+        bool covered = false;
+        for(uint8_t l = 0; l < LED_LAYER_COUNT; l++)
+        {
+            if(layers_[l].mask & LED_CHANNEL_MASK(ch))
+            {
+                Blend(covered ? layers_[l].blend : (uint8_t)LED_BLEND_REPLACE, layers_[l].colors[ch], result);
+                covered = true;
+            }
+        }
+
+        //channel left by all layers is turned off
+        if(!covered)
+        {
+            COLOR off_color = OFFCOLOR;
+            result.assign(composed_count_[ch], off_color);
+        }
+        composed_count_[ch] = result.size();
+        output_.mask |= LED_CHANNEL_MASK(ch);
+    }
+    return output_;
+}
+
+void LedCompositor::Blend(uint8_t blend, const std::vector<COLOR> &layer, std::vector<COLOR> &result)
+{
+    if(blend == LED_BLEND_REPLACE)
+    {
+        result.assign(layer.begin(), layer.end());
+        return;
+    }
+
+    //shorter buffer is extended by leds which are off
+    COLOR off_color = OFFCOLOR;
+    if(result.size() < layer.size())
+    {
+        result.resize(layer.size(), off_color);
+    }
+
+    const uint8_t *src = (const uint8_t*)layer.data();
+    uint8_t *dst = (uint8_t*)result.data();
+    size_t bytes = layer.size() * sizeof(COLOR);
+    switch(blend)
+    {
+        case LED_BLEND_ADD:
+            for(size_t i = 0; i < bytes; i++)
+            {
+                dst[i] = std::min(dst[i] + src[i], 255);
+            }
+            break;
+        case LED_BLEND_MAX:
+            for(size_t i = 0; i < bytes; i++)
+            {
+                dst[i] = std::max(dst[i], src[i]);
+            }
+            break;
+        case LED_BLEND_MULTIPLY:
+            for(size_t i = 0; i < bytes; i++)
+            {
+                dst[i] = (dst[i] * src[i] + 127) / 255;
+            }
+            //leds without layer color are masked out
+            std::fill(dst + bytes, dst + result.size() * sizeof(COLOR), 0);
+            break;
+        default:
+            break;
+    }
+}
+
+const char *LedCompositor::LayerName(uint8_t layer)
+{
+    switch(layer)
+    {
+        case LED_LAYER_BASE:
+            return "base";
+        case LED_LAYER_STATUS:
+            return "status";
+        case LED_LAYER_ESC_STATUS:
+            return "esc_status";
+        case LED_LAYER_SAFETY:
+            return "safety";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,606 @@
+#include "led_effect.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+static uint64_t GreatestCommonDivisor(uint64_t a, uint64_t b)
+{
+    while(b)
+    {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+//values of other types would throw on conversion, all readers return false instead
+static bool XmlNumber(XmlRpc::XmlRpcValue &value, double &number)
+{
+    if(value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+    {
+        number = (int)value;
+        return true;
+    }
+    if(value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+    {
+        number = (double)value;
+        return true;
+    }
+    return false;
+}
+
+static bool XmlInteger(XmlRpc::XmlRpcValue &value, int min, int max, int &number)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeInt)
+    {
+        return false;
+    }
+    number = (int)value;
+    return number >= min && number <= max;
+}
+
+static bool XmlString(XmlRpc::XmlRpcValue &value, std::string &text)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeString)
+    {
+        return false;
+    }
+    text = static_cast<std::string>(value);
+    return true;
+}
+
+static bool XmlBool(XmlRpc::XmlRpcValue &value, bool &flag)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeBoolean)
+    {
+        return false;
+    }
+    flag = (bool)value;
+    return true;
+}
+
+static bool XmlColor(XmlRpc::XmlRpcValue &value, COLOR &color)
+{
+    if(value.getType() != XmlRpc::XmlRpcValue::TypeArray || value.size() != 3)
+    {
+        return false;
+    }
+    int r, g, b;
+    if(!XmlInteger(value[0], 0, 255, r) || !XmlInteger(value[1], 0, 255, g) || !XmlInteger(value[2], 0, 255, b))
+    {
+        return false;
+    }
+    color.r = r;
+    color.g = g;
+    color.b = b;
+    return true;
+}
+
+static int ChannelByName(const std::string &name)
+{
+    static const char *names[LED_CHANNEL_COUNT] = {"fl", "fr", "rl", "rr", "ad"};
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if(name == names[ch])
+        {
+            return ch;
+        }
+    }
+    return -1;
+}
+
+size_t LedEffect::FrameCount() const
+{
+    return durations.size();
+}
+
+const COLOR *LedEffect::Channel(size_t frame, uint8_t channel) const
+{
+    return &colors[(frame * LED_CHANNEL_COUNT + channel) * leds_count];
+}
+
+size_t LedEffect::FrameAt(uint32_t tick) const
+{
+    return std::upper_bound(starts.begin(), starts.end(), tick) - starts.begin() - 1;
+}
+
+bool LedEffect::Compile(const LedEffectDescription &description, LedEffect &effect, std::string &error)
+{
+    if(description.tracks.empty())
+    {
+        error = "no tracks";
+        return true;
+    }
+    if(description.leds_count == 0 || description.leds_count > LED_EFFECT_MAX_LEDS)
+    {
+        error = "leds_count out of range";
+        return true;
+    }
+
+    //validate tracks, loop length is common multiple of all track periods
+    uint8_t mask = 0;
+    uint64_t length = description.loop ? 1 : 0;
+    std::vector<uint64_t> periods;
+    for(size_t t = 0; t < description.tracks.size(); t++)
+    {
+        const LedEffectTrack &track = description.tracks[t];
+        if(!track.mask || (track.mask & mask) || (track.mask & ~LED_CHANNEL_MASK_ALL))
+        {
+            error = "track channels are empty, unknown or used by another track";
+            return true;
+        }
+        if(track.steps.empty())
+        {
+            error = "track without steps";
+            return true;
+        }
+
+        uint64_t period = 0;
+        for(size_t s = 0; s < track.steps.size(); s++)
+        {
+            if(track.steps[s].ticks == 0 || track.steps[s].pattern.size() > description.leds_count)
+            {
+                error = "step is shorter than one tick or has more colors than leds_count";
+                return true;
+            }
+            period += track.steps[s].ticks;
+        }
+
+        mask |= track.mask;
+        periods.push_back(period);
+        length = description.loop ? (length / GreatestCommonDivisor(length, period)) * period : std::max(length, period);
+        if(length > LED_EFFECT_MAX_TICKS)
+        {
+            error = "effect is too long";
+            return true;
+        }
+    }
+
+    //frame starts wherever any track starts new step
+    std::vector<uint64_t> starts;
+    for(size_t t = 0; t < description.tracks.size(); t++)
+    {
+        const LedEffectTrack &track = description.tracks[t];
+        for(uint64_t base = 0; base < length; base += periods[t])
+        {
+            uint64_t start = base;
+            for(size_t s = 0; s < track.steps.size() && start < length; s++)
+            {
+                starts.push_back(start);
+                start += track.steps[s].ticks;
+            }
+            if(!description.loop)
+            {
+                break;
+            }
+        }
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+    size_t frames = starts.size();
+    if(frames * LED_CHANNEL_COUNT * description.leds_count > LED_EFFECT_MAX_COLORS)
+    {
+        error = "frame table is too large";
+        return true;
+    }
+
+    effect.id = description.id;
+    effect.name = description.name;
+    effect.mask = mask;
+    effect.leds_count = description.leds_count;
+    effect.loop = description.loop;
+    effect.tick_period_s = 0.0;
+    effect.length = length;
+    COLOR off_color = OFFCOLOR;
+    effect.colors.assign(frames * LED_CHANNEL_COUNT * description.leds_count, off_color);
+    effect.durations.resize(frames);
+    effect.starts.assign(starts.begin(), starts.end());
+    effect.changed.assign(frames, 0);
+
+    for(size_t f = 0; f < frames; f++)
+    {
+        effect.durations[f] = ((f + 1 < frames) ? starts[f + 1] : length) - starts[f];
+
+        for(size_t t = 0; t < description.tracks.size(); t++)
+        {
+            const LedEffectTrack &track = description.tracks[t];
+
+            //finished track of non-looping effect holds its last step
+            uint64_t position = description.loop ? starts[f] % periods[t] : starts[f];
+            size_t step = track.steps.size() - 1;
+            bool step_starts = false;
+            uint64_t step_start = 0;
+            for(size_t s = 0; s < track.steps.size(); s++)
+            {
+                if(position < step_start + track.steps[s].ticks)
+                {
+                    step = s;
+                    step_starts = (position == step_start);
+                    break;
+                }
+                step_start += track.steps[s].ticks;
+            }
+
+            const std::vector<COLOR> &pattern = track.steps[step].pattern;
+            for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+            {
+                if(track.mask & LED_CHANNEL_MASK(ch))
+                {
+                    std::copy(pattern.begin(), pattern.end(), effect.colors.begin() + (f * LED_CHANNEL_COUNT + ch) * description.leds_count);
+                }
+            }
+            if(f == 0 || step_starts)
+            {
+                effect.changed[f] |= track.mask;
+            }
+        }
+    }
+
+    return false;
+}
+
+void LedEffectLibrary::Load(const ros::NodeHandle &nh, double tick_period_s, uint16_t capacity)
+{
+    effects_.clear();
+
+    std::vector<LedEffectDescription> descriptions = DefaultDescriptions();
+    for(size_t i = 0; i < descriptions.size(); i++)
+    {
+        this->Add(descriptions[i], tick_period_s, capacity);
+    }
+
+    //list of {id, name, leds_count, loop, tracks: [{channels: [fl, ...], steps: [{duration, color | pattern}]}]}
+    XmlRpc::XmlRpcValue effects;
+    if(nh.getParam("led_effects", effects) && effects.getType() == XmlRpc::XmlRpcValue::TypeArray)
+    {
+        for(int i = 0; i < effects.size(); i++)
+        {
+            LedEffectDescription description;
+            std::string error;
+            if(ReadDescription(effects[i], tick_period_s, description, error))
+            {
+                ROS_ERROR("LED EFFECT - led_effects item %d ignored, %s", i, error.c_str());
+                continue;
+            }
+            this->Add(description, tick_period_s, capacity);
+        }
+    }
+}
+
+void LedEffectLibrary::Add(const LedEffectDescription &description, double tick_period_s, uint16_t capacity)
+{
+    //frames are rendered into buffers sized by led/capacity
+    if(description.leds_count > capacity)
+    {
+        ROS_ERROR("LED EFFECT - effect %u (%s) ignored, leds_count %u exceeds led/capacity %u", description.id, description.name.c_str(), description.leds_count, capacity);
+        return;
+    }
+
+    LedEffect effect;
+    std::string error;
+    if(LedEffect::Compile(description, effect, error))
+    {
+        ROS_WARN("LED EFFECT - effect %u (%s) ignored, %s", description.id, description.name.c_str(), error.c_str());
+        return;
+    }
+    effect.tick_period_s = tick_period_s;
+
+    ROS_INFO("LED EFFECT - effect %u (%s), %zu frames", effect.id, effect.name.c_str(), effect.FrameCount());
+    effects_[effect.id] = effect;
+}
+
+bool LedEffectLibrary::ReadDescription(XmlRpc::XmlRpcValue &item, double tick_period_s, LedEffectDescription &description, std::string &error)
+{
+    if(item.getType() != XmlRpc::XmlRpcValue::TypeStruct || !item.hasMember("id") || !item.hasMember("tracks") ||
+        item["tracks"].getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+        error = "id and tracks are required";
+        return true;
+    }
+
+    int id;
+    if(!XmlInteger(item["id"], 0, UINT8_MAX, id))
+    {
+        error = "id must be integer 0-255";
+        return true;
+    }
+    description.id = id;
+
+    description.name = "effect";
+    if(item.hasMember("name") && !XmlString(item["name"], description.name))
+    {
+        error = "name must be string";
+        return true;
+    }
+
+    int leds_count = LED_EFFECT_DEFAULT_LEDS;
+    if(item.hasMember("leds_count") && !XmlInteger(item["leds_count"], 1, LED_EFFECT_MAX_LEDS, leds_count))
+    {
+        error = "leds_count must be integer 1-" + std::to_string(LED_EFFECT_MAX_LEDS);
+        return true;
+    }
+    description.leds_count = leds_count;
+
+    description.loop = true;
+    if(item.hasMember("loop") && !XmlBool(item["loop"], description.loop))
+    {
+        error = "loop must be true or false";
+        return true;
+    }
+
+    XmlRpc::XmlRpcValue &tracks = item["tracks"];
+    for(int t = 0; t < tracks.size(); t++)
+    {
+        XmlRpc::XmlRpcValue &track_item = tracks[t];
+        if(track_item.getType() != XmlRpc::XmlRpcValue::TypeStruct || !track_item.hasMember("channels") || !track_item.hasMember("steps") ||
+            track_item["channels"].getType() != XmlRpc::XmlRpcValue::TypeArray || track_item["steps"].getType() != XmlRpc::XmlRpcValue::TypeArray)
+        {
+            error = "track requires channels and steps";
+            return true;
+        }
+
+        LedEffectTrack track;
+        track.mask = 0;
+        XmlRpc::XmlRpcValue &channels = track_item["channels"];
+        for(int c = 0; c < channels.size(); c++)
+        {
+            std::string name;
+            int channel = XmlString(channels[c], name) ? ChannelByName(name) : -1;
+            if(channel < 0)
+            {
+                error = "unknown channel, use fl, fr, rl, rr or ad";
+                return true;
+            }
+            track.mask |= LED_CHANNEL_MASK(channel);
+        }
+
+        XmlRpc::XmlRpcValue &steps = track_item["steps"];
+        for(int s = 0; s < steps.size(); s++)
+        {
+            XmlRpc::XmlRpcValue &step_item = steps[s];
+            if(step_item.getType() != XmlRpc::XmlRpcValue::TypeStruct || !step_item.hasMember("duration"))
+            {
+                error = "step requires duration";
+                return true;
+            }
+
+            double duration;
+            if(!XmlNumber(step_item["duration"], duration) || duration <= 0.0 || duration / tick_period_s > LED_EFFECT_MAX_TICKS)
+            {
+                error = "step duration must be positive number of seconds";
+                return true;
+            }
+
+            LedEffectStep step;
+            step.ticks = std::max((long)1, lround(duration / tick_period_s));
+            if(step_item.hasMember("pattern"))
+            {
+                XmlRpc::XmlRpcValue &pattern = step_item["pattern"];
+                if(pattern.getType() != XmlRpc::XmlRpcValue::TypeArray)
+                {
+                    error = "pattern must be list of [r, g, b]";
+                    return true;
+                }
+                for(int l = 0; l < pattern.size(); l++)
+                {
+                    COLOR color;
+                    if(!XmlColor(pattern[l], color))
+                    {
+                        error = "pattern color must be [r, g, b] of integers 0-255";
+                        return true;
+                    }
+                    step.pattern.push_back(color);
+                }
+            }
+            else if(step_item.hasMember("color"))
+            {
+                COLOR color;
+                if(!XmlColor(step_item["color"], color))
+                {
+                    error = "color must be [r, g, b] of integers 0-255";
+                    return true;
+                }
+                step.pattern.assign(description.leds_count, color);
+            }
+            track.steps.push_back(step);
+        }
+        description.tracks.push_back(track);
+    }
+
+    return false;
+}
+
+const LedEffect *LedEffectLibrary::Find(uint8_t id) const
+{
+    std::map<uint8_t, LedEffect>::const_iterator it = effects_.find(id);
+    if(it == effects_.end())
+    {
+        return NULL;
+    }
+    return &it->second;
+}
+
+std::vector<LedEffectDescription> LedEffectLibrary::DefaultDescriptions()
+{
+    COLOR white = WHITE;
+    COLOR red = RED;
+    COLOR off_color = OFFCOLOR;
+    std::vector<LedEffectDescription> descriptions;
+
+    //all arm LEDs off once
+    LedEffectDescription no_effect;
+    no_effect.id = 0;
+    no_effect.name = "no_effect";
+    no_effect.leds_count = LED_EFFECT_DEFAULT_LEDS;
+    no_effect.loop = false;
+    LedEffectTrack arms;
+    arms.mask = LED_CHANNEL_MASK_ARMS;
+    LedEffectStep off_step;
+    off_step.ticks = 1;
+    arms.steps.push_back(off_step);
+    no_effect.tracks.push_back(arms);
+    descriptions.push_back(no_effect);
+
+    //front halves swap white every 4 ticks, rear halves swap red every 8 ticks
+    LedEffectDescription flight_mode;
+    flight_mode.id = 1;
+    flight_mode.name = "flight_mode";
+    flight_mode.leds_count = LED_EFFECT_DEFAULT_LEDS;
+    flight_mode.loop = true;
+    uint16_t half = LED_EFFECT_DEFAULT_LEDS / 2;
+    const uint8_t masks[2] = {LED_CHANNEL_MASK(LED_CHANNEL_FL) | LED_CHANNEL_MASK(LED_CHANNEL_FR),
+                              LED_CHANNEL_MASK(LED_CHANNEL_RL) | LED_CHANNEL_MASK(LED_CHANNEL_RR)};
+    const COLOR colors[2] = {white, red};
+    const uint32_t ticks[2] = {4, 8};
+    for(uint8_t t = 0; t < 2; t++)
+    {
+        LedEffectTrack track;
+        track.mask = masks[t];
+        LedEffectStep first_half, second_half;
+        first_half.ticks = ticks[t];
+        first_half.pattern.assign(half, colors[t]);
+        second_half.ticks = ticks[t];
+        second_half.pattern.assign(half, off_color);
+        second_half.pattern.insert(second_half.pattern.end(), half, colors[t]);
+        track.steps.push_back(first_half);
+        track.steps.push_back(second_half);
+        flight_mode.tracks.push_back(track);
+    }
+    descriptions.push_back(flight_mode);
+
+    return descriptions;
+}
+
+LedEffectPlayer::LedEffectPlayer()
+    :effect_(NULL),
+     position_(0),
+     started_(false),
+     frames_(0),
+     skipped_frames_(0),
+     window_frames_(0),
+     window_phase_error_ns_(0),
+     window_max_phase_error_ns_(0)
+{
+}
+
+void LedEffectPlayer::Start(const LedEffect *effect, const ros::Time &start)
+{
+    effect_ = effect;
+    start_ = start;
+    position_ = 0;
+    started_ = false;
+}
+
+bool LedEffectPlayer::IsRunning() const
+{
+    return effect_ != NULL;
+}
+
+bool LedEffectPlayer::Tick(const ros::Time &now, LedFrame &frame)
+{
+    if(!effect_)
+    {
+        return false;
+    }
+
+    //shared start is still ahead
+    double elapsed_s = (now - start_).toSec();
+    if(elapsed_s < 0.0)
+    {
+        return false;
+    }
+
+    //small margin keeps tick boundaries exact despite rounding of time
+    uint64_t tick = (uint64_t)floor(elapsed_s / effect_->tick_period_s + 1e-6);
+    uint64_t loop_start = 0;
+    bool finished = false;
+    if(effect_->loop)
+    {
+        loop_start = tick - tick % effect_->length;
+    }
+    else if(tick >= effect_->length)
+    {
+        //last frame stays on LEDs
+        finished = true;
+        tick = effect_->length - 1;
+    }
+
+    size_t index = effect_->FrameAt(tick - loop_start);
+    uint64_t position = (loop_start / effect_->length) * effect_->FrameCount() + index;
+    bool write = false;
+    if(!started_)
+    {
+        //effect joined at any point of shared timeline, whole frame is written
+        started_ = true;
+        write = true;
+        this->FillFrame(index, effect_->mask, frame);
+    }
+    else if(position > position_)
+    {
+        write = true;
+        uint8_t mask = effect_->changed[index];
+        if(position > position_ + 1)
+        {
+            //late tick, frames in between are not shown and their changes have to be written too
+            skipped_frames_.fetch_add(position - position_ - 1, std::memory_order_relaxed);
+            mask = effect_->mask;
+        }
+        this->FillFrame(index, mask, frame);
+        this->CountPhaseError(elapsed_s - (loop_start + effect_->starts[index]) * effect_->tick_period_s);
+    }
+    position_ = position;
+
+    if(finished)
+    {
+        effect_ = NULL;
+    }
+    if(write)
+    {
+        frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return write;
+}
+
+LedEffectPlayer::Stats LedEffectPlayer::ReadStats() const
+{
+    Stats stats;
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.skipped_frames = skipped_frames_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void LedEffectPlayer::ReadWindowPhaseError(double &mean_s, double &max_s)
+{
+    uint64_t frames = window_frames_.exchange(0, std::memory_order_relaxed);
+    uint64_t sum_ns = window_phase_error_ns_.exchange(0, std::memory_order_relaxed);
+    mean_s = frames ? (sum_ns * 1e-9) / frames : 0.0;
+    max_s = window_max_phase_error_ns_.exchange(0, std::memory_order_relaxed) * 1e-9;
+}
+
+void LedEffectPlayer::CountPhaseError(double phase_error_s)
+{
+    uint64_t phase_error_ns = (uint64_t)(std::max(phase_error_s, 0.0) * 1e9);
+    window_frames_.fetch_add(1, std::memory_order_relaxed);
+    window_phase_error_ns_.fetch_add(phase_error_ns, std::memory_order_relaxed);
+    //window max is reset by reader
+    uint64_t window_max = window_max_phase_error_ns_.load(std::memory_order_relaxed);
+    while(phase_error_ns > window_max && !window_max_phase_error_ns_.compare_exchange_weak(window_max, phase_error_ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LedEffectPlayer::FillFrame(size_t frame, uint8_t mask, LedFrame &frame_out) const
+{
+    //output frame is reused by caller, channels of previous frames must not be written again
+    frame_out.mask = 0;
+    frame_out.update_count = false;
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        if(mask & LED_CHANNEL_MASK(ch))
+        {
+            frame_out.SetChannel(ch, effect_->Channel(frame, ch), effect_->leds_count);
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#include "led_latency_benchmark.hpp"
+
+#include <algorithm>
+
+#include <boost/make_shared.hpp>
+
+LedLatencyBenchmark::LedLatencyBenchmark(const ros::NodeHandle &nh, const ros::NodeHandle &private_nh)
+    :nh_(nh),
+     private_nh_(private_nh),
+     sent_(0),
+     failed_(0),
+     coalesced_(0),
+     reported_(false)
+{
+    int count;
+    double rate;
+    std::string control_ns;
+    private_nh_.param<int>("count", count, 2000);
+    private_nh_.param<double>("rate", rate, 100.0);
+    private_nh_.param<std::string>("control_ns", control_ns, "ae_powerboard_control");
+    count_ = std::max(count, 1);
+    rate = std::max(rate, 1.0);
+
+    round_trip_ms_.reserve(count_);
+    status_delivery_ms_.reserve(count_);
+    telemetry_delivery_ms_.reserve(count_);
+
+    //same transport hints as subscribers of control
+    led_color_cmd_pub_ = nh_.advertise<ae_powerboard_control::LedColorCommand>(control_ns + "/led/cmd/set_color", 10);
+    led_command_status_sub_ = nh_.subscribe(control_ns + "/led/cmd/status", 100, &LedLatencyBenchmark::CallbackLedCommandStatus, this, ros::TransportHints().tcpNoDelay());
+    esc_data_log_sub_ = nh_.subscribe(control_ns + "/esc/data_log", 10, &LedLatencyBenchmark::CallbackEscDataLog, this, ros::TransportHints().tcpNoDelay());
+    command_timer_ = nh_.createTimer(ros::Duration(1.0 / rate), &LedLatencyBenchmark::CallbackCommandTimer, this);
+    report_timer_ = nh_.createTimer(ros::Duration(1.0), &LedLatencyBenchmark::CallbackReportTimer, this, true, false);
+}
+
+void LedLatencyBenchmark::CallbackCommandTimer(const ros::TimerEvent &event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    //commands are sent only after control subscribed, first ones would be lost
+    if(sent_ == 0 && led_color_cmd_pub_.getNumSubscribers() == 0)
+    {
+        return;
+    }
+    if(sent_ == 0)
+    {
+        ROS_INFO("LED LATENCY - started, %u commands", count_);
+    }
+
+    ae_powerboard_control::LedColorCommand::Ptr msg = boost::make_shared<ae_powerboard_control::LedColorCommand>();
+    msg->id = sent_;
+    msg->leds_count = 8;
+    msg->leds_color.r = (uint8_t)sent_;
+    msg->leds_color.g = (uint8_t)(sent_ * 3);
+    msg->leds_color.b = (uint8_t)(sent_ * 7);
+    msg->enable_add = false;
+    pending_[msg->id] = ros::WallTime::now();
+    led_color_cmd_pub_.publish(msg);
+
+    //last statuses are waited for before report
+    if(++sent_ >= count_)
+    {
+        command_timer_.stop();
+        report_timer_.start();
+    }
+}
+
+void LedLatencyBenchmark::CallbackReportTimer(const ros::TimerEvent &event)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    this->Report();
+}
+
+void LedLatencyBenchmark::CallbackLedCommandStatus(const ae_powerboard_control::LedCommandStatus::ConstPtr &msg)
+{
+    ros::WallTime received = ros::WallTime::now();
+    double delivery_ms = (ros::Time::now() - msg->stamp).toSec() * 1e3;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<uint32_t, ros::WallTime>::iterator it = pending_.find(msg->id);
+    if(msg->command != ae_powerboard_control::LedCommandStatus::SET_COLOR || it == pending_.end() || reported_)
+    {
+        return;
+    }
+    round_trip_ms_.push_back((received - it->second).toSec() * 1e3);
+    status_delivery_ms_.push_back(delivery_ms);
+    failed_ += msg->success ? 0 : 1;
+    coalesced_ += msg->coalesced ? 1 : 0;
+    pending_.erase(it);
+}
+
+void LedLatencyBenchmark::CallbackEscDataLog(const ae_powerboard_control::EscDataLogs::ConstPtr &msg)
+{
+    double delivery_ms = (ros::Time::now() - msg->stamp).toSec() * 1e3;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    //telemetry is counted only while commands are running
+    if(sent_ == 0 || reported_)
+    {
+        return;
+    }
+    telemetry_delivery_ms_.push_back(delivery_ms);
+}
+
+void LedLatencyBenchmark::Report()
+{
+    if(reported_)
+    {
+        return;
+    }
+    reported_ = true;
+
+    ROS_INFO("LED LATENCY - %u commands, %zu without status, %u failed, %u coalesced", sent_, pending_.size(), failed_, coalesced_);
+    ReportLatency("round_trip", round_trip_ms_);
+    ReportLatency("status_delivery", status_delivery_ms_);
+    ReportLatency("telemetry_age", telemetry_delivery_ms_);
+    ROS_INFO("LED LATENCY - done");
+}
+
+void LedLatencyBenchmark::ReportLatency(const char *name, std::vector<double> &latencies_ms)
+{
+    if(latencies_ms.empty())
+    {
+        ROS_INFO("LED LATENCY - %-16s no samples", name);
+        return;
+    }
+
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    double sum = 0.0;
+    for(size_t i = 0; i < latencies_ms.size(); i++)
+    {
+        sum += latencies_ms[i];
+    }
+    size_t n = latencies_ms.size();
+    ROS_INFO("LED LATENCY - %-16s %6zu samples, mean %8.3f ms, p50 %8.3f ms, p99 %8.3f ms, max %8.3f ms", name, n, sum / n,
+        latencies_ms[n / 2], latencies_ms[std::min(n - 1, n * 99 / 100)], latencies_ms[n - 1]);
+}
@@ -0,0 +1,13 @@
+#include "led_latency_benchmark.hpp"
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "led_latency_benchmark");
+    ros::NodeHandle n;
+    ros::NodeHandle private_n("~");
+
+    LedLatencyBenchmark benchmark(n, private_n);
+    ros::spin();
+
+    return 0;
+}
@@ -0,0 +1,10 @@
+#include "led_latency_benchmark_nodelet.hpp"
+
+#include "pluginlib/class_list_macros.h"
+
+void LedLatencyBenchmarkNodelet::onInit()
+{
+    benchmark_.reset(new LedLatencyBenchmark(this->getMTNodeHandle(), this->getMTPrivateNodeHandle()));
+}
+
+PLUGINLIB_EXPORT_CLASS(LedLatencyBenchmarkNodelet, nodelet::Nodelet)
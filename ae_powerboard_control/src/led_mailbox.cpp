@@ -0,0 +1,154 @@
+#include "led_mailbox.hpp"
+
+LedMailbox::LedMailbox()
+    :full_(false),
+     next_ticket_(1),
+     slot_ticket_(0),
+     completed_count_(0),
+     received_(0),
+     applied_(0),
+     dropped_(0)
+{
+}
+
+void LedMailbox::Reserve(uint16_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    slot_.Reserve(count);
+}
+
+bool LedMailbox::Put(LedFrame &frame)
+{
+    uint64_t ticket;
+    return this->Put(frame, ticket);
+}
+
+bool LedMailbox::Put(LedFrame &frame, uint64_t &ticket)
+{
+    received_.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool was_empty = !full_;
+    if(!was_empty)
+    {
+        //previous frame was not applied in time, its other channels are still wanted
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+        {
+            if((slot_.mask & LED_CHANNEL_MASK(ch)) && !(frame.mask & LED_CHANNEL_MASK(ch)))
+            {
+                std::swap(slot_.colors[ch], frame.colors[ch]);
+            }
+        }
+        frame.mask |= slot_.mask;
+        frame.update_count = frame.update_count || slot_.update_count;
+    }
+    std::swap(slot_, frame);
+    full_ = true;
+    ticket = next_ticket_++;
+    slot_ticket_ = ticket;
+    return was_empty;
+}
+
+bool LedMailbox::Take(LedFrame &frame)
+{
+    uint64_t ticket;
+    return this->Take(frame, ticket);
+}
+
+bool LedMailbox::Take(LedFrame &frame, uint64_t &ticket)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(!full_)
+    {
+        return false;
+    }
+    std::swap(slot_, frame);
+    full_ = false;
+    ticket = slot_ticket_;
+    last_take_ = Clock::now();
+    return true;
+}
+
+void LedMailbox::Complete(uint64_t ticket, uint8_t status)
+{
+    applied_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Completion &completion = completed_[completed_count_ % LED_MAILBOX_HISTORY];
+        completion.ticket = ticket;
+        completion.status = status;
+        completed_count_++;
+    }
+    condition_.notify_all();
+}
+
+bool LedMailbox::Discard(uint8_t status, uint64_t &ticket)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!full_)
+        {
+            return false;
+        }
+        full_ = false;
+        ticket = slot_ticket_;
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+
+        Completion &completion = completed_[completed_count_ % LED_MAILBOX_HISTORY];
+        completion.ticket = ticket;
+        completion.status = status;
+        completed_count_++;
+    }
+    condition_.notify_all();
+    return true;
+}
+
+uint8_t LedMailbox::Wait(uint64_t ticket, double timeout_s, bool &coalesced)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeout_s));
+    bool timeout = false;
+    while(true)
+    {
+        //ticket is covered by first applied ticket which is not older
+        uint64_t first = (completed_count_ > LED_MAILBOX_HISTORY) ? completed_count_ - LED_MAILBOX_HISTORY : 0;
+        const Completion *covering = NULL;
+        for(uint64_t i = first; i < completed_count_; i++)
+        {
+            const Completion &completion = completed_[i % LED_MAILBOX_HISTORY];
+            if(completion.ticket >= ticket && (!covering || completion.ticket < covering->ticket))
+            {
+                covering = &completion;
+            }
+        }
+        if(covering)
+        {
+            coalesced = (covering->ticket != ticket);
+            return covering->status;
+        }
+
+        if(timeout)
+        {
+            coalesced = false;
+            return LED_MAILBOX_STATUS_TIMEOUT;
+        }
+        timeout = (condition_.wait_until(lock, deadline) == std::cv_status::timeout);
+    }
+}
+
+double LedMailbox::TakeDelay(double period_s)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    double since_s = std::chrono::duration<double>(Clock::now() - last_take_).count();
+    return period_s - since_s;
+}
+
+LedMailbox::Stats LedMailbox::ReadStats() const
+{
+    Stats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.applied = applied_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,438 @@
+#include "led_output.hpp"
+
+#include <string.h>
+
+LedFrame::LedFrame()
+    :mask(0),
+     update_count(false)
+{
+}
+
+void LedFrame::Reserve(uint16_t count)
+{
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        colors[i].reserve(count);
+    }
+}
+
+void LedFrame::SetChannel(uint8_t channel, const COLOR *buffer, uint16_t count)
+{
+    colors[channel].assign(buffer, buffer + count);
+    mask |= LED_CHANNEL_MASK(channel);
+}
+
+void LedFrame::FillChannel(uint8_t channel, const COLOR &color, uint16_t count)
+{
+    colors[channel].assign(count, color);
+    mask |= LED_CHANNEL_MASK(channel);
+}
+
+LedOutput::LedOutput()
+    :leds_count_valid_(false),
+     shadow_valid_(0),
+     source_valid_(0),
+     scale_(LED_COLOR_SCALE_ONE),
+     predefined_effect_valid_(false),
+     predefined_enabled_(false),
+     predefined_enabled_valid_(false),
+     frames_(0),
+     sent_bytes_(0),
+     skipped_bytes_(0),
+     sent_channels_(0),
+     skipped_channels_(0),
+     skipped_updates_(0),
+     skipped_config_writes_(0),
+     limited_frames_(0),
+     shown_load_(0)
+{
+    memset(&leds_count_, 0, sizeof(LEDS_COUNT));
+    memset(load_, 0, sizeof(load_));
+}
+
+void LedOutput::ConfigureColor(const LedColorConfig &config)
+{
+    color_.Configure(config);
+}
+
+void LedOutput::Reserve(uint16_t count)
+{
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        shadow_[i].reserve(count);
+        source_[i].reserve(count);
+        output_[i].reserve(count);
+    }
+}
+
+uint8_t LedOutput::SetBrightness(PowerboardBackend &board, double brightness)
+{
+    color_.SetBrightness(brightness);
+
+    //shown channels with new brightness
+    bool changed = false;
+    uint8_t status = this->Render(board, source_valid_, changed);
+    if(changed)
+    {
+        status |= board.LedsUpdate();
+    }
+    return status;
+}
+
+uint8_t LedOutput::Commit(PowerboardBackend &board, const LedFrame &frame)
+{
+    uint8_t status = 0;
+    bool changed = false;
+
+    frames_++;
+
+    //update led count, board is read only once and then tracked here
+    if(frame.update_count)
+    {
+        status |= this->ReadCount(board);
+        LEDS_COUNT leds_count = leds_count_;
+        for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+        {
+            if(frame.mask & LED_CHANNEL_MASK(i))
+            {
+                SetCount(leds_count, i, frame.colors[i].size());
+            }
+        }
+        status |= this->WriteCount(board, leds_count, changed);
+    }
+
+    //source colors are kept for re-render
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        if(frame.mask & LED_CHANNEL_MASK(i))
+        {
+            source_[i].assign(frame.colors[i].begin(), frame.colors[i].end());
+        }
+    }
+    source_valid_ |= frame.mask;
+    status |= this->Render(board, frame.mask, changed);
+
+    //update led buffer, nothing to show when all channels were skipped
+    if(changed)
+    {
+        status |= board.LedsUpdate();
+    }
+    else
+    {
+        skipped_updates_++;
+    }
+
+    return status;
+}
+
+uint8_t LedOutput::CommitCount(PowerboardBackend &board, uint8_t mask, uint16_t count)
+{
+    uint8_t status = this->ReadCount(board);
+    bool written = false;
+
+    LEDS_COUNT leds_count = leds_count_;
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        if(mask & LED_CHANNEL_MASK(i))
+        {
+            SetCount(leds_count, i, count);
+        }
+    }
+    status |= this->WriteCount(board, leds_count, written);
+
+    return status;
+}
+
+uint8_t LedOutput::SwitchPredefinedEffect(PowerboardBackend &board, bool enable)
+{
+    if(predefined_enabled_valid_ && predefined_enabled_ == enable)
+    {
+        skipped_config_writes_++;
+        return 0;
+    }
+
+    uint8_t status = board.LedsSwitchPredefinedEffect(enable);
+    predefined_enabled_ = enable;
+    predefined_enabled_valid_ = (status == 0);
+
+    //board renders leds by itself, content is unknown from now
+    if(enable)
+    {
+        this->Invalidate();
+    }
+    return status;
+}
+
+uint8_t LedOutput::CommitPredefinedEffect(PowerboardBackend &board, const LedPredefinedEffect &effect, uint16_t count)
+{
+    uint8_t status = this->ReadCount(board);
+
+    LEDS_COUNT leds_count = leds_count_;
+    for(uint8_t i = LED_CHANNEL_FL; i <= LED_CHANNEL_RR; i++)
+    {
+        SetCount(leds_count, i, count);
+    }
+    bool count_changed = false;
+    bool effect_changed = !predefined_effect_valid_ || !SamePredefinedEffect(predefined_effect_, effect);
+    bool count_differs = memcmp(&leds_count, &leds_count_, sizeof(LEDS_COUNT)) != 0;
+
+    //running effect with same configuration
+    if(!effect_changed && !count_differs && predefined_enabled_valid_ && predefined_enabled_)
+    {
+        skipped_config_writes_++;
+        return status;
+    }
+
+    //effect is reconfigured while stopped
+    status |= this->SwitchPredefinedEffect(board, false);
+
+    status |= this->WriteCount(board, leds_count, count_changed);
+
+    if(effect_changed)
+    {
+        //board renders effect by itself, only its colors are corrected
+        COLOR colors[4] = {effect.front_left, effect.front_right, effect.rear_left, effect.rear_right};
+        color_.Apply(colors, colors, 4);
+        uint8_t effect_status = board.LedsSetPredefinedEffect(colors[0], colors[1], colors[2], colors[3],
+            effect.on_led_cycles, effect.off_led_cycles, effect.effect_type, effect.set_default);
+        predefined_effect_ = effect;
+        predefined_effect_valid_ = (effect_status == 0);
+        status |= effect_status;
+    }
+    else
+    {
+        skipped_config_writes_++;
+    }
+
+    //update led buffer
+    status |= board.LedsUpdate();
+
+    //turn on predefinned effect
+    status |= this->SwitchPredefinedEffect(board, true);
+
+    return status;
+}
+
+void LedOutput::Invalidate()
+{
+    shadow_valid_ = 0;
+    //predefined effect owns leds, nothing to re-render
+    source_valid_ = 0;
+    memset(load_, 0, sizeof(load_));
+}
+
+uint8_t LedOutput::ShownMask() const
+{
+    return source_valid_;
+}
+
+bool LedOutput::PredefinedEnabled() const
+{
+    return predefined_enabled_valid_ && predefined_enabled_;
+}
+
+uint8_t LedOutput::Render(PowerboardBackend &board, uint8_t mask, bool &changed)
+{
+    uint8_t status = 0;
+
+    //correction of changed channels, load of others is kept from their last render
+    mask &= source_valid_;
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        if(mask & LED_CHANNEL_MASK(i))
+        {
+            output_[i].resize(source_[i].size());
+            load_[i] = color_.Apply(source_[i].data(), output_[i].data(), source_[i].size());
+        }
+    }
+
+    //current cap is common for all channels, new scale re-renders all of them
+    uint64_t load = 0;
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        load += load_[i];
+    }
+    uint16_t scale = color_.CapScale(load);
+    if(scale != scale_)
+    {
+        for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+        {
+            if((source_valid_ & ~mask) & LED_CHANNEL_MASK(i))
+            {
+                output_[i].resize(source_[i].size());
+                color_.Apply(source_[i].data(), output_[i].data(), source_[i].size());
+            }
+        }
+        mask = source_valid_;
+        scale_ = scale;
+    }
+    if(scale_ < LED_COLOR_SCALE_ONE)
+    {
+        for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+        {
+            if(mask & LED_CHANNEL_MASK(i))
+            {
+                LedColorPipeline::Scale(output_[i].data(), output_[i].size(), scale_);
+            }
+        }
+        limited_frames_++;
+    }
+    shown_load_ = (load * scale_) >> 8;
+
+    //channel buffers, only those which differ from shadow
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        if(mask & LED_CHANNEL_MASK(i))
+        {
+            status |= this->Send(board, i, changed);
+        }
+    }
+    return status;
+}
+
+uint8_t LedOutput::Send(PowerboardBackend &board, uint8_t channel, bool &changed)
+{
+    const std::vector<COLOR> &colors = output_[channel];
+    //nothing is sent, board buffer and its shadow stay as they are
+    if(colors.empty())
+    {
+        return 0;
+    }
+
+    uint32_t bytes = colors.size() * sizeof(COLOR);
+    if((shadow_valid_ & LED_CHANNEL_MASK(channel)) && shadow_[channel].size() == colors.size() &&
+       memcmp(shadow_[channel].data(), colors.data(), bytes) == 0)
+    {
+        skipped_bytes_ += bytes;
+        skipped_channels_++;
+        return 0;
+    }
+
+    uint8_t status = board.LedsSendColorBuffer(ChannelBuffer(channel), (COLOR*)colors.data(), colors.size());
+    sent_bytes_ += bytes;
+    sent_channels_++;
+
+    if(status)
+    {
+        shadow_valid_ &= ~LED_CHANNEL_MASK(channel);
+    }
+    else
+    {
+        shadow_[channel].assign(colors.begin(), colors.end());
+        shadow_valid_ |= LED_CHANNEL_MASK(channel);
+    }
+    changed = true;
+    return status;
+}
+
+LedOutput::Stats LedOutput::ReadStats() const
+{
+    Stats stats;
+    stats.frames = frames_;
+    stats.sent_bytes = sent_bytes_;
+    stats.skipped_bytes = skipped_bytes_;
+    stats.sent_channels = sent_channels_;
+    stats.skipped_channels = skipped_channels_;
+    stats.skipped_updates = skipped_updates_;
+    stats.skipped_config_writes = skipped_config_writes_;
+    stats.limited_frames = limited_frames_;
+    stats.estimated_current_ma = color_.Current(shown_load_);
+    return stats;
+}
+
+uint8_t LedOutput::ReadCount(PowerboardBackend &board)
+{
+    if(leds_count_valid_)
+    {
+        return 0;
+    }
+
+    uint8_t status = board.LedsGetLedsCount(leds_count_);
+    leds_count_valid_ = (status == 0);
+    return status;
+}
+
+uint8_t LedOutput::WriteCount(PowerboardBackend &board, const LEDS_COUNT &leds_count, bool &written)
+{
+    if(leds_count_valid_ && memcmp(&leds_count, &leds_count_, sizeof(LEDS_COUNT)) == 0)
+    {
+        skipped_config_writes_++;
+        return 0;
+    }
+
+    uint8_t status = board.LedsSetLedsCount(leds_count);
+    leds_count_ = leds_count;
+    //force read of board on next write when it failed
+    leds_count_valid_ = (status == 0);
+    written = true;
+    return status;
+}
+
+bool LedOutput::SameColor(const COLOR &a, const COLOR &b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+bool LedOutput::SamePredefinedEffect(const LedPredefinedEffect &a, const LedPredefinedEffect &b)
+{
+    return SameColor(a.front_left, b.front_left) && SameColor(a.front_right, b.front_right) &&
+           SameColor(a.rear_left, b.rear_left) && SameColor(a.rear_right, b.rear_right) &&
+           a.on_led_cycles == b.on_led_cycles && a.off_led_cycles == b.off_led_cycles &&
+           a.effect_type == b.effect_type && a.set_default == b.set_default;
+}
+
+uint8_t LedOutput::ChannelBuffer(uint8_t channel)
+{
+    switch(channel)
+    {
+        case LED_CHANNEL_FL:
+            return fl_buffer;
+        case LED_CHANNEL_FR:
+            return fr_buffer;
+        case LED_CHANNEL_RL:
+            return rl_buffer;
+        case LED_CHANNEL_RR:
+            return rr_buffer;
+        default:
+            return ad_buffer;
+    }
+}
+
+uint16_t LedOutput::GetCount(const LEDS_COUNT &leds_count, uint8_t channel)
+{
+    switch(channel)
+    {
+        case LED_CHANNEL_FL:
+            return leds_count.fl_leds_count;
+        case LED_CHANNEL_FR:
+            return leds_count.fr_leds_count;
+        case LED_CHANNEL_RL:
+            return leds_count.rl_leds_count;
+        case LED_CHANNEL_RR:
+            return leds_count.rr_leds_count;
+        default:
+            return leds_count.ad_leds_count;
+    }
+}
+
+void LedOutput::SetCount(LEDS_COUNT &leds_count, uint8_t channel, uint16_t count)
+{
+    switch(channel)
+    {
+        case LED_CHANNEL_FL:
+            leds_count.fl_leds_count = count;
+            break;
+        case LED_CHANNEL_FR:
+            leds_count.fr_leds_count = count;
+            break;
+        case LED_CHANNEL_RL:
+            leds_count.rl_leds_count = count;
+            break;
+        case LED_CHANNEL_RR:
+            leds_count.rr_leds_count = count;
+            break;
+        default:
+            leds_count.ad_leds_count = count;
+            break;
+    }
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "led_output.hpp"
+#include "bus_metrics.hpp"
+#include "simulated_backend.hpp"
+
+/*
+*  Bus time of LED frames written by LedOutput (shadow diff, cached counts) against writing
+*  every channel of every frame. Board is simulated with latency per call and per payload byte.
+*
+*  usage: led_output_benchmark [frames] [leds] [transaction_latency_us] [byte_latency_us]
+*/
+
+#define BENCHMARK_ADD_LEDS_FACTOR 2
+
+enum Benchmark_Scenario
+{
+    SCENARIO_STATIC = 0,        //same frame again, e.g. held color or slow effect
+    SCENARIO_ONE_ARM = 1,       //one arm toggles, rest holds
+    SCENARIO_CIRCLE = 2,        //one lit LED runs around every arm
+    SCENARIO_ALL_CHANGED = 3,   //every LED of every channel changes
+    SCENARIO_COUNT = 4,
+};
+
+static const char *ScenarioName(uint8_t scenario)
+{
+    static const char *names[SCENARIO_COUNT] = {"static", "one_arm", "circle", "all_changed"};
+    return names[scenario];
+}
+
+static void FillFrame(uint8_t scenario, uint32_t index, uint16_t leds, LedFrame &frame)
+{
+    COLOR off = {0, 0, 0};
+    COLOR red = {255, 0, 0};
+    COLOR green = {0, 255, 0};
+
+    frame.mask = 0;
+    frame.update_count = true;
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        uint16_t count = (ch == LED_CHANNEL_AD) ? leds * BENCHMARK_ADD_LEDS_FACTOR : leds;
+        frame.FillChannel(ch, green, count);
+        std::vector<COLOR> &colors = frame.colors[ch];
+        switch(scenario)
+        {
+            case SCENARIO_ONE_ARM:
+            {
+                if(ch == LED_CHANNEL_FL && (index & 0x01))
+                {
+                    std::fill(colors.begin(), colors.end(), red);
+                }
+                break;
+            }
+            case SCENARIO_CIRCLE:
+            {
+                if(ch != LED_CHANNEL_AD)
+                {
+                    std::fill(colors.begin(), colors.end(), off);
+                    colors[index % count] = red;
+                }
+                break;
+            }
+            case SCENARIO_ALL_CHANGED:
+            {
+                for(uint16_t i = 0; i < count; i++)
+                {
+                    colors[i].r = (uint8_t)(index + i);
+                    colors[i].g = (uint8_t)(index * 3 + ch);
+                    colors[i].b = (uint8_t)(index * 7);
+                }
+                break;
+            }
+        }
+    }
+}
+
+//how frames were written before output stage: counts, every buffer and update
+static uint8_t WriteFull(PowerboardBackend &board, LedFrame &frame)
+{
+    LEDS_COUNT leds_count;
+    memset(&leds_count, 0, sizeof(LEDS_COUNT));
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        LedOutput::SetCount(leds_count, ch, frame.colors[ch].size());
+    }
+
+    uint8_t status = board.LedsSetLedsCount(leds_count);
+    for(uint8_t ch = 0; ch < LED_CHANNEL_COUNT; ch++)
+    {
+        status |= board.LedsSendColorBuffer(LedOutput::ChannelBuffer(ch), frame.colors[ch].data(), frame.colors[ch].size());
+    }
+    return status | board.LedsUpdate();
+}
+
+static void PrintResult(const char *scenario, const char *writer, uint32_t frames, const BusMetrics::Snapshot &now, const BusMetrics::Snapshot &before)
+{
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    for(uint8_t i = 0; i < BusMetrics::OP_COUNT; i++)
+    {
+        calls += now.operations[i].count - before.operations[i].count;
+        errors += now.operations[i].errors - before.operations[i].errors;
+    }
+    double busy_ms = (now.busy_ns - before.busy_ns) * 1e-6;
+    printf("%-12s %-6s %8u %12.3f %12.2f %8lu\n", scenario, writer, frames, busy_ms / frames, (double)calls / frames, (unsigned long)errors);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = (argc >= 2) ? atoi(argv[1]) : 200;
+    uint16_t leds = (argc >= 3) ? atoi(argv[2]) : 8;
+
+    //same latencies as control_sim.launch
+    SimulatedBackend::Config config;
+    config.transaction_latency_us = (argc >= 4) ? atoi(argv[3]) : 200;
+    config.byte_latency_us = (argc >= 5) ? atoi(argv[4]) : 25;
+    config.error_rate = 0.0;
+    config.seed = 0;
+    config.turning_off_s = 0.0;
+
+    if(frames == 0 || leds == 0)
+    {
+        fprintf(stderr, "usage: %s [frames] [leds] [transaction_latency_us] [byte_latency_us]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%u frames, %u LEDs per arm, %u us per call, %u us per byte\n", frames, leds, config.transaction_latency_us, config.byte_latency_us);
+    printf("%-12s %-6s %8s %12s %12s %8s\n", "scenario", "writer", "frames", "bus_ms/frame", "calls/frame", "errors");
+
+    LedFrame frame;
+    frame.Reserve(leds * BENCHMARK_ADD_LEDS_FACTOR);
+    for(uint8_t scenario = 0; scenario < SCENARIO_COUNT; scenario++)
+    {
+        //every writer starts with fresh board
+        {
+            BusMetrics metrics;
+            MeteredBackend board(new SimulatedBackend(config), metrics);
+            board.Open("sim");
+            BusMetrics::Snapshot before = metrics.Read();
+            for(uint32_t i = 0; i < frames; i++)
+            {
+                FillFrame(scenario, i, leds, frame);
+                WriteFull(board, frame);
+            }
+            PrintResult(ScenarioName(scenario), "full", frames, metrics.Read(), before);
+        }
+        {
+            BusMetrics metrics;
+            MeteredBackend board(new SimulatedBackend(config), metrics);
+            board.Open("sim");
+            LedOutput output;
+            output.Reserve(leds * BENCHMARK_ADD_LEDS_FACTOR);
+            BusMetrics::Snapshot before = metrics.Read();
+            for(uint32_t i = 0; i < frames; i++)
+            {
+                FillFrame(scenario, i, leds, frame);
+                output.Commit(board, frame);
+            }
+            PrintResult(ScenarioName(scenario), "output", frames, metrics.Read(), before);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "ros/ros.h"
+#include "ae_powerboard_control/SetLedColor.h"
+#include "ae_powerboard_control/SetLedCustomColor.h"
+
+/*
+*  Latency of led services seen by clients, from call until response. Several clients call
+*  at once, so requests queue behind each other and newer frames coalesce older ones.
+*  Run against control_sim.launch to get bus latencies without hardware.
+*
+*  usage: led_service_benchmark [calls] [clients] [leds] [node]
+*/
+
+struct BenchmarkResult
+{
+    std::vector<double> latencies_ms;
+    uint32_t coalesced;
+    uint32_t failed;
+};
+
+static ae_powerboard_control::Color BenchmarkColor(uint32_t index)
+{
+    ae_powerboard_control::Color color;
+    color.r = (uint8_t)index;
+    color.g = (uint8_t)(index * 3);
+    color.b = (uint8_t)(index * 7);
+    return color;
+}
+
+static bool CallColor(ros::ServiceClient &client, uint32_t index, uint16_t leds, bool &coalesced)
+{
+    ae_powerboard_control::SetLedColor srv;
+    srv.request.leds_count = leds;
+    srv.request.leds_color = BenchmarkColor(index);
+    srv.request.enable_add = true;
+    srv.request.leds_add_count = leds;
+    srv.request.add_color = srv.request.leds_color;
+    if(!client.call(srv))
+    {
+        return false;
+    }
+    coalesced = srv.response.coalesced;
+    return srv.response.success;
+}
+
+static bool CallCustomColor(ros::ServiceClient &client, uint32_t index, uint16_t leds, bool &coalesced)
+{
+    ae_powerboard_control::SetLedCustomColor srv;
+    ae_powerboard_control::LedChannel *channels[] = {&srv.request.front_left, &srv.request.front_right, &srv.request.rear_left, &srv.request.rear_right, &srv.request.add};
+    for(size_t ch = 0; ch < sizeof(channels) / sizeof(channels[0]); ch++)
+    {
+        for(uint16_t i = 0; i < leds; i++)
+        {
+            channels[ch]->color.push_back(BenchmarkColor(index + i + ch));
+        }
+    }
+    srv.request.enable_add = true;
+    if(!client.call(srv))
+    {
+        return false;
+    }
+    coalesced = srv.response.coalesced;
+    return srv.response.success;
+}
+
+template<class T>
+static void RunClient(ros::NodeHandle &nh, const std::string &service, uint32_t calls, uint16_t leds, uint32_t seed,
+    bool (*call)(ros::ServiceClient&, uint32_t, uint16_t, bool&), BenchmarkResult &result)
+{
+    //persistent connection, only callback and bus are measured
+    ros::ServiceClient client = nh.serviceClient<T>(service, true);
+    result.latencies_ms.reserve(calls);
+    result.coalesced = 0;
+    result.failed = 0;
+    for(uint32_t i = 0; i < calls; i++)
+    {
+        bool coalesced = false;
+        ros::WallTime start = ros::WallTime::now();
+        bool success = call(client, seed + i, leds, coalesced);
+        result.latencies_ms.push_back((ros::WallTime::now() - start).toSec() * 1e3);
+        result.coalesced += coalesced ? 1 : 0;
+        result.failed += success ? 0 : 1;
+    }
+}
+
+template<class T>
+static void RunService(ros::NodeHandle &nh, const std::string &node, const char *name, uint32_t calls, uint32_t clients, uint16_t leds,
+    bool (*call)(ros::ServiceClient&, uint32_t, uint16_t, bool&))
+{
+    std::string service = node + "/led/" + name;
+    if(!ros::service::waitForService(service, ros::Duration(5.0)))
+    {
+        ROS_ERROR("Service \"%s\" does not exist!", service.c_str());
+        return;
+    }
+
+    std::vector<BenchmarkResult> results(clients);
+    std::vector<std::thread> threads;
+    for(uint32_t c = 0; c < clients; c++)
+    {
+        threads.push_back(std::thread(RunClient<T>, std::ref(nh), service, calls, leds, c * calls, call, std::ref(results[c])));
+    }
+    for(uint32_t c = 0; c < clients; c++)
+    {
+        threads[c].join();
+    }
+
+    std::vector<double> latencies_ms;
+    uint32_t coalesced = 0;
+    uint32_t failed = 0;
+    for(uint32_t c = 0; c < clients; c++)
+    {
+        latencies_ms.insert(latencies_ms.end(), results[c].latencies_ms.begin(), results[c].latencies_ms.end());
+        coalesced += results[c].coalesced;
+        failed += results[c].failed;
+    }
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    double sum = 0.0;
+    for(size_t i = 0; i < latencies_ms.size(); i++)
+    {
+        sum += latencies_ms[i];
+    }
+    size_t n = latencies_ms.size();
+    printf("%-18s %8u %8zu %10.3f %10.3f %10.3f %10.3f %10u %8u\n", name, clients, n, sum / n, latencies_ms[n / 2],
+        latencies_ms[std::min(n - 1, n * 99 / 100)], latencies_ms[n - 1], coalesced, failed);
+}
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "led_service_benchmark", ros::init_options::AnonymousName);
+    ros::NodeHandle nh;
+
+    uint32_t calls = (argc >= 2) ? atoi(argv[1]) : 500;
+    uint32_t clients = (argc >= 3) ? atoi(argv[2]) : 1;
+    uint16_t leds = (argc >= 4) ? atoi(argv[3]) : 8;
+    std::string node = (argc >= 5) ? argv[4] : "ae_powerboard_control";
+
+    if(calls == 0 || clients == 0 || leds == 0)
+    {
+        fprintf(stderr, "usage: %s [calls] [clients] [leds] [node]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%u calls per client, %u LEDs per arm, %s\n", calls, leds, node.c_str());
+    printf("%-18s %8s %8s %10s %10s %10s %10s %10s %8s\n", "service", "clients", "calls", "mean_ms", "p50_ms", "p99_ms", "max_ms", "coalesced", "failed");
+    RunService<ae_powerboard_control::SetLedColor>(nh, node, "set_color", calls, clients, leds, CallColor);
+    RunService<ae_powerboard_control::SetLedCustomColor>(nh, node, "set_custom_color", calls, clients, leds, CallCustomColor);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+#include "led_status.hpp"
+
+#include <algorithm>
+
+#include "utils.hpp"
+
+LedStatusConfig::LedStatusConfig()
+    :enable(false),
+     leds_count(8),
+     esc_temp_warning(80.0),
+     esc_temp_critical(100.0),
+     motor_temp_warning(80.0),
+     motor_temp_critical(110.0),
+     hysteresis(3.0),
+     warning_mask(0xffffffff),
+     error_mask(0xffffffff),
+     show_ok(false)
+{
+    COLOR ok = {0, 255, 0};
+    COLOR warning = {255, 128, 0};
+    COLOR critical = {255, 0, 0};
+    COLOR board = {0, 0, 255};
+    colors[LED_STATUS_OK] = ok;
+    colors[LED_STATUS_WARNING] = warning;
+    colors[LED_STATUS_CRITICAL] = critical;
+    colors[LED_STATUS_BOARD] = board;
+}
+
+LedStatus::LedStatus()
+    :rendered_(false)
+{
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        esc_temp_levels_[i] = LED_STATUS_OK;
+        motor_temp_levels_[i] = LED_STATUS_OK;
+        levels_[i] = LED_STATUS_OK;
+    }
+}
+
+void LedStatus::Load(const ros::NodeHandle &nh, uint16_t capacity)
+{
+    LedStatusConfig config;
+    int leds_count, warning_mask, error_mask;
+    nh.param<bool>("led_status/enable", config.enable, config.enable);
+    nh.param<int>("led_status/leds_count", leds_count, config.leds_count);
+    nh.param<double>("led_status/esc_temp_warning", config.esc_temp_warning, config.esc_temp_warning);
+    nh.param<double>("led_status/esc_temp_critical", config.esc_temp_critical, config.esc_temp_critical);
+    nh.param<double>("led_status/motor_temp_warning", config.motor_temp_warning, config.motor_temp_warning);
+    nh.param<double>("led_status/motor_temp_critical", config.motor_temp_critical, config.motor_temp_critical);
+    nh.param<double>("led_status/hysteresis", config.hysteresis, config.hysteresis);
+    //bit masks of ERROR_WARN_LOG, -1 selects all bits
+    nh.param<int>("led_status/warning_mask", warning_mask, -1);
+    nh.param<int>("led_status/error_mask", error_mask, -1);
+    config.leds_count = std::min(std::max(leds_count, 1), std::min((int)capacity, LED_EFFECT_MAX_LEDS));
+    config.warning_mask = (uint32_t)warning_mask;
+    config.error_mask = (uint32_t)error_mask;
+    config.show_ok = ReadColor(nh, "led_status/ok_color", config.colors[LED_STATUS_OK]);
+    ReadColor(nh, "led_status/warning_color", config.colors[LED_STATUS_WARNING]);
+    ReadColor(nh, "led_status/critical_color", config.colors[LED_STATUS_CRITICAL]);
+    ReadColor(nh, "led_status/board_color", config.colors[LED_STATUS_BOARD]);
+    config_ = config;
+}
+
+bool LedStatus::IsEnabled() const
+{
+    return config_.enable;
+}
+
+uint8_t LedStatus::Update(const TelemetrySnapshot &telemetry)
+{
+    uint8_t changed = 0;
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        uint8_t level = LED_STATUS_OK;
+
+        if(telemetry.esc_data_log_status & (1 << i))
+        {
+            Utils::EscDataValues values = Utils::ConvertDataLog(telemetry.esc_data_log[i]);
+            esc_temp_levels_[i] = this->TempLevel(values.esc_max_temp, config_.esc_temp_warning, config_.esc_temp_critical, esc_temp_levels_[i]);
+            motor_temp_levels_[i] = this->TempLevel(values.motor_max_temp, config_.motor_temp_warning, config_.motor_temp_critical, motor_temp_levels_[i]);
+            level = std::max(esc_temp_levels_[i], motor_temp_levels_[i]);
+        }
+
+        if(telemetry.esc_error_log_status & (1 << i))
+        {
+            const ERR_WARN &last = telemetry.esc_error_log[i].Last;
+            if(last.Error & config_.error_mask)
+            {
+                level = std::max(level, (uint8_t)LED_STATUS_CRITICAL);
+            }
+            else if(last.Warn & config_.warning_mask)
+            {
+                level = std::max(level, (uint8_t)LED_STATUS_WARNING);
+            }
+        }
+
+        //board going down overrides health of single ESC
+        if(telemetry.power_board_status != program_state_run)
+        {
+            level = LED_STATUS_BOARD;
+        }
+
+        if(!rendered_ || level != levels_[i])
+        {
+            changed |= LED_CHANNEL_MASK(i);
+        }
+        levels_[i] = level;
+    }
+    rendered_ = true;
+    return changed;
+}
+
+void LedStatus::Render(uint8_t mask, LedFrame &frame, uint8_t &clear) const
+{
+    clear = 0;
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        if(!(mask & LED_CHANNEL_MASK(i)))
+        {
+            continue;
+        }
+        if(levels_[i] == LED_STATUS_OK && !config_.show_ok)
+        {
+            clear |= LED_CHANNEL_MASK(i);
+            continue;
+        }
+        frame.FillChannel(i, config_.colors[levels_[i]], config_.leds_count);
+    }
+}
+
+uint8_t LedStatus::Level(uint8_t esc_index) const
+{
+    return levels_[esc_index];
+}
+
+uint8_t LedStatus::TempLevel(double temp, double warning, double critical, uint8_t current) const
+{
+    //level which is already shown is held until temperature drops by hysteresis
+    if(temp >= critical - ((current >= LED_STATUS_CRITICAL) ? config_.hysteresis : 0.0))
+    {
+        return LED_STATUS_CRITICAL;
+    }
+    if(temp >= warning - ((current >= LED_STATUS_WARNING) ? config_.hysteresis : 0.0))
+    {
+        return LED_STATUS_WARNING;
+    }
+    return LED_STATUS_OK;
+}
+
+bool LedStatus::ReadColor(const ros::NodeHandle &nh, const std::string &name, COLOR &color)
+{
+    XmlRpc::XmlRpcValue rgb;
+    if(!nh.getParam(name, rgb))
+    {
+        return false;
+    }
+    //checked before conversion, values out of uint8 would wrap and other types would throw
+    bool valid = rgb.getType() == XmlRpc::XmlRpcValue::TypeArray && rgb.size() == 3;
+    for(int i = 0; valid && i < 3; i++)
+    {
+        valid = rgb[i].getType() == XmlRpc::XmlRpcValue::TypeInt && (int)rgb[i] >= 0 && (int)rgb[i] <= 255;
+    }
+    if(!valid)
+    {
+        ROS_WARN("LED STATUS - %s has to be [r, g, b] of integers 0-255, default color is used", name.c_str());
+        return false;
+    }
+    color.r = (uint8_t)(int)rgb[0];
+    color.g = (uint8_t)(int)rgb[1];
+    color.b = (uint8_t)(int)rgb[2];
+    return true;
+}
+
+const char *LedStatus::LevelName(uint8_t level)
+{
+    switch(level)
+    {
+        case LED_STATUS_OK:
+            return "ok";
+        case LED_STATUS_WARNING:
+            return "warning";
+        case LED_STATUS_CRITICAL:
+            return "critical";
+        case LED_STATUS_BOARD:
+            return "board";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,95 @@
+#include "powerboard_backend.hpp"
+
+HardwareBackend::HardwareBackend()
+{
+    drone_control_ = new Pb6s40aDroneControl(i2c_driver_, I2C2_MAIN_BOARD_ADDRESS);
+    led_control_ = new Pb6s40aLedsControl(i2c_driver_, I2C2_MAIN_BOARD_ADDRESS);
+}
+
+HardwareBackend::~HardwareBackend()
+{
+    delete drone_control_;
+    delete led_control_;
+}
+
+bool HardwareBackend::Open(const std::string &port)
+{
+    return i2c_driver_.I2cOpen(port.c_str());
+}
+
+void HardwareBackend::Close()
+{
+    i2c_driver_.I2cClose();
+}
+
+bool HardwareBackend::IsSimulated() const
+{
+    return false;
+}
+
+uint8_t HardwareBackend::PowerBoardStatusGet(uint8_t *status)
+{
+    return drone_control_->PowerBoardStatusGet(status);
+}
+
+uint8_t HardwareBackend::PowerBoardInfoGet(POWER_BOARD_INFO *info)
+{
+    return drone_control_->PowerBoardInfoGet(info);
+}
+
+uint8_t HardwareBackend::DroneTurnOff()
+{
+    return drone_control_->DroneTurnOff();
+}
+
+uint8_t HardwareBackend::EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc)
+{
+    return drone_control_->EscGetErrorLogs(log, esc);
+}
+
+uint8_t HardwareBackend::EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc)
+{
+    return drone_control_->EscGetDataLogs(log, esc);
+}
+
+uint8_t HardwareBackend::EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc)
+{
+    return drone_control_->EscGetDeviceInfo(info, esc);
+}
+
+uint8_t HardwareBackend::EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc)
+{
+    return drone_control_->EscGetResistance(resistance, esc);
+}
+
+uint8_t HardwareBackend::LedsSwitchPredefinedEffect(bool enable)
+{
+    return led_control_->LedsSwitchPredefinedEffect(enable);
+}
+
+uint8_t HardwareBackend::LedsGetLedsCount(LEDS_COUNT &leds_count)
+{
+    return led_control_->LedsGetLedsCount(leds_count);
+}
+
+uint8_t HardwareBackend::LedsSetLedsCount(LEDS_COUNT leds_count)
+{
+    return led_control_->LedsSetLedsCount(leds_count);
+}
+
+uint8_t HardwareBackend::LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count)
+{
+    return led_control_->LedsSendColorBuffer(buffer, colors, count);
+}
+
+uint8_t HardwareBackend::LedsUpdate()
+{
+    return led_control_->LedsUpdate();
+}
+
+uint8_t HardwareBackend::LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+    uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default)
+{
+    return led_control_->LedsSetPredefinedEffect(front_left, front_right, rear_left, rear_right,
+        on_led_cycles, off_led_cycles, effect_type, set_default);
+}
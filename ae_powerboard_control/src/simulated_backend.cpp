@@ -0,0 +1,336 @@
+#include "simulated_backend.hpp"
+
+#include <thread>
+#include <algorithm>
+
+static double XmlNumber(XmlRpc::XmlRpcValue &value)
+{
+    if(value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+    {
+        return (int)value;
+    }
+    return (double)value;
+}
+
+static bool CompareSampleTime(const SimulatedBackend::EscSample &a, const SimulatedBackend::EscSample &b)
+{
+    return a.time_s < b.time_s;
+}
+
+SimulatedBackend::SimulatedBackend(const Config &config)
+    :config_(config),
+     random_(config.seed),
+     error_distribution_(0.0, 1.0),
+     script_index_(0),
+     program_state_(program_state_run),
+     predefined_enabled_(false),
+     predefined_effect_type_(0)
+{
+    std::stable_sort(config_.esc_script.begin(), config_.esc_script.end(), CompareSampleTime);
+
+    memset(&board_info_, 0, sizeof(POWER_BOARD_INFO));
+    board_info_.fw_number.major = 1;
+    board_info_.hw_build = 0x01;
+
+    for(uint8_t i = 0; i < SIMULATED_ESC_COUNT; i++)
+    {
+        ERROR_WARN_LOG er_log = ERROR_WARN_LOG_INIT;
+        esc_error_log_[i] = er_log;
+
+        //idle esc at 25 deg C
+        memset(&esc_data_log_[i], 0, sizeof(RUN_DATA_Struct));
+        esc_data_log_[i].Temp_ESC_Max = 25 + 50;
+        esc_data_log_[i].Temp_Motor_Max = 25 + 50;
+
+        memset(&esc_device_info_[i], 0, sizeof(ADB_DEVICE_INFO));
+        esc_device_info_[i].fw_number.major = 1;
+        esc_device_info_[i].device_address = esc1 + i;
+        esc_device_info_[i].hw_build = 0x01;
+        esc_device_info_[i].serial_number = 1000 + i;
+
+        memset(&esc_resistance_[i], 0, sizeof(RESISTANCE_STRUCT));
+        esc_resistance_[i].Phase[0] = 0.05f;
+        esc_resistance_[i].Phase[1] = 0.05f;
+        esc_resistance_[i].Phase[2] = 0.05f;
+        esc_resistance_[i].Global = 0.05f;
+    }
+
+    memset(&leds_count_, 0, sizeof(LEDS_COUNT));
+}
+
+SimulatedBackend::Config SimulatedBackend::ReadConfig(const ros::NodeHandle &nh)
+{
+    Config config;
+    int transaction_latency_us, byte_latency_us, seed;
+    nh.param<int>("sim/transaction_latency_us", transaction_latency_us, 200);
+    nh.param<int>("sim/byte_latency_us", byte_latency_us, 25);
+    nh.param<int>("sim/seed", seed, 0);
+    nh.param<double>("sim/error_rate", config.error_rate, 0.0);
+    nh.param<double>("sim/turning_off_s", config.turning_off_s, 0.0);
+    config.transaction_latency_us = std::max(transaction_latency_us, 0);
+    config.byte_latency_us = std::max(byte_latency_us, 0);
+    config.seed = seed;
+
+    //list of {time, esc, esc_temp, motor_temp, is_max, is_avg, error, warning}
+    XmlRpc::XmlRpcValue script;
+    if(nh.getParam("sim/esc_script", script) && script.getType() == XmlRpc::XmlRpcValue::TypeArray)
+    {
+        for(int i = 0; i < script.size(); i++)
+        {
+            XmlRpc::XmlRpcValue &item = script[i];
+            if(item.getType() != XmlRpc::XmlRpcValue::TypeStruct || !item.hasMember("time") || !item.hasMember("esc"))
+            {
+                ROS_WARN("SIM - esc_script item %d ignored, time and esc are required", i);
+                continue;
+            }
+
+            EscSample sample;
+            sample.time_s = XmlNumber(item["time"]);
+            sample.esc = (uint8_t)XmlNumber(item["esc"]);
+            sample.esc_temp = item.hasMember("esc_temp") ? XmlNumber(item["esc_temp"]) : NAN;
+            sample.motor_temp = item.hasMember("motor_temp") ? XmlNumber(item["motor_temp"]) : NAN;
+            sample.is_max = item.hasMember("is_max") ? XmlNumber(item["is_max"]) : NAN;
+            sample.is_avg = item.hasMember("is_avg") ? XmlNumber(item["is_avg"]) : NAN;
+            sample.error = item.hasMember("error") ? (int64_t)XmlNumber(item["error"]) : -1;
+            sample.warning = item.hasMember("warning") ? (int64_t)XmlNumber(item["warning"]) : -1;
+            config.esc_script.push_back(sample);
+        }
+    }
+
+    return config;
+}
+
+bool SimulatedBackend::Open(const std::string &port)
+{
+    open_time_ = Clock::now();
+    script_index_ = 0;
+    return false;
+}
+
+void SimulatedBackend::Close()
+{
+}
+
+bool SimulatedBackend::IsSimulated() const
+{
+    return true;
+}
+
+uint8_t SimulatedBackend::Transaction(uint32_t bytes)
+{
+    uint32_t latency_us = config_.transaction_latency_us + bytes * config_.byte_latency_us;
+    if(latency_us)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(latency_us));
+    }
+
+    if(config_.error_rate > 0.0 && error_distribution_(random_) < config_.error_rate)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+void SimulatedBackend::RunScript()
+{
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - open_time_).count();
+
+    if(config_.turning_off_s > 0.0 && elapsed_s >= config_.turning_off_s)
+    {
+        program_state_ = program_state_turning_off;
+    }
+
+    while(script_index_ < config_.esc_script.size() && config_.esc_script[script_index_].time_s <= elapsed_s)
+    {
+        const EscSample &sample = config_.esc_script[script_index_++];
+        int i = this->EscIndex(sample.esc);
+        if(i < 0)
+        {
+            continue;
+        }
+
+        //firmware representation, temperatures with +50 offset, Is avg in 0.1 A, Is max in I4Q8
+        if(!std::isnan(sample.esc_temp))
+        {
+            esc_data_log_[i].Temp_ESC_Max = (int)roundf(sample.esc_temp) + 50;
+        }
+        if(!std::isnan(sample.motor_temp))
+        {
+            esc_data_log_[i].Temp_Motor_Max = (int)roundf(sample.motor_temp) + 50;
+        }
+        if(!std::isnan(sample.is_avg))
+        {
+            esc_data_log_[i].Is_Motor_Avg = (int)roundf(sample.is_avg * 10.0f);
+        }
+        if(!std::isnan(sample.is_max))
+        {
+            esc_data_log_[i].Is_Motor_Max = ((int32_t)roundf(sample.is_max * 256.0f)) & 0x0fff;
+        }
+        if(sample.error >= 0 || sample.warning >= 0)
+        {
+            ERROR_WARN_LOG &er_log = esc_error_log_[i];
+            er_log.Prev = er_log.Last;
+            er_log.Last.Error = (sample.error >= 0) ? sample.error : 0;
+            er_log.Last.Warn = (sample.warning >= 0) ? sample.warning : 0;
+            er_log.All.Error |= er_log.Last.Error;
+            er_log.All.Warn |= er_log.Last.Warn;
+        }
+    }
+}
+
+int SimulatedBackend::EscIndex(uint8_t esc) const
+{
+    int i = esc - esc1;
+    if(i < 0 || i >= SIMULATED_ESC_COUNT)
+    {
+        return -1;
+    }
+    return i;
+}
+
+uint8_t SimulatedBackend::PowerBoardStatusGet(uint8_t *status)
+{
+    this->RunScript();
+    if(this->Transaction(1))
+    {
+        return 1;
+    }
+    *status = program_state_;
+    return 0;
+}
+
+uint8_t SimulatedBackend::PowerBoardInfoGet(POWER_BOARD_INFO *info)
+{
+    if(this->Transaction(sizeof(POWER_BOARD_INFO)))
+    {
+        return 1;
+    }
+    *info = board_info_;
+    return 0;
+}
+
+uint8_t SimulatedBackend::DroneTurnOff()
+{
+    if(this->Transaction(1))
+    {
+        return 1;
+    }
+    program_state_ = program_state_turning_off;
+    return 0;
+}
+
+uint8_t SimulatedBackend::EscGetErrorLogs(ERROR_WARN_LOG *log, uint8_t esc)
+{
+    this->RunScript();
+    int i = this->EscIndex(esc);
+    if(this->Transaction(sizeof(ERROR_WARN_LOG)) || i < 0)
+    {
+        return 1;
+    }
+    *log = esc_error_log_[i];
+    return 0;
+}
+
+uint8_t SimulatedBackend::EscGetDataLogs(RUN_DATA_Struct *log, uint8_t esc)
+{
+    this->RunScript();
+    int i = this->EscIndex(esc);
+    if(this->Transaction(sizeof(RUN_DATA_Struct)) || i < 0)
+    {
+        return 1;
+    }
+    *log = esc_data_log_[i];
+    return 0;
+}
+
+uint8_t SimulatedBackend::EscGetDeviceInfo(ADB_DEVICE_INFO *info, uint8_t esc)
+{
+    int i = this->EscIndex(esc);
+    if(this->Transaction(sizeof(ADB_DEVICE_INFO)) || i < 0)
+    {
+        return 1;
+    }
+    *info = esc_device_info_[i];
+    return 0;
+}
+
+uint8_t SimulatedBackend::EscGetResistance(RESISTANCE_STRUCT *resistance, uint8_t esc)
+{
+    int i = this->EscIndex(esc);
+    if(this->Transaction(sizeof(RESISTANCE_STRUCT)) || i < 0)
+    {
+        return 1;
+    }
+    *resistance = esc_resistance_[i];
+    return 0;
+}
+
+uint8_t SimulatedBackend::LedsSwitchPredefinedEffect(bool enable)
+{
+    if(this->Transaction(1))
+    {
+        return 1;
+    }
+    predefined_enabled_ = enable;
+    return 0;
+}
+
+uint8_t SimulatedBackend::LedsGetLedsCount(LEDS_COUNT &leds_count)
+{
+    if(this->Transaction(sizeof(LEDS_COUNT)))
+    {
+        return 1;
+    }
+    leds_count = leds_count_;
+    return 0;
+}
+
+uint8_t SimulatedBackend::LedsSetLedsCount(LEDS_COUNT leds_count)
+{
+    if(this->Transaction(sizeof(LEDS_COUNT)))
+    {
+        return 1;
+    }
+    leds_count_ = leds_count;
+    return 0;
+}
+
+uint8_t SimulatedBackend::LedsSendColorBuffer(uint8_t buffer, COLOR *colors, uint16_t count)
+{
+    int i = 0;
+    while(i < LED_CHANNEL_COUNT && LedOutput::ChannelBuffer(i) != buffer)
+    {
+        i++;
+    }
+
+    if(this->Transaction(count * sizeof(COLOR)) || i >= LED_CHANNEL_COUNT)
+    {
+        return 1;
+    }
+    leds_pending_[i].assign(colors, colors + count);
+    return 0;
+}
+
+uint8_t SimulatedBackend::LedsUpdate()
+{
+    if(this->Transaction(1))
+    {
+        return 1;
+    }
+    for(uint8_t i = 0; i < LED_CHANNEL_COUNT; i++)
+    {
+        leds_shown_[i] = leds_pending_[i];
+    }
+    return 0;
+}
+
+uint8_t SimulatedBackend::LedsSetPredefinedEffect(COLOR front_left, COLOR front_right, COLOR rear_left, COLOR rear_right,
+    uint8_t on_led_cycles, uint8_t off_led_cycles, uint8_t effect_type, bool set_default)
+{
+    if(this->Transaction(4 * sizeof(COLOR) + 4))
+    {
+        return 1;
+    }
+    predefined_effect_type_ = effect_type;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "telemetry_refresh.hpp"
+
+bool TelemetryRefresh::RunEsc(uint8_t data_class, uint8_t esc_index, const Read &read)
+{
+    return this->Run(esc_pending_[data_class][esc_index], read);
+}
+
+bool TelemetryRefresh::RunBoard(const Read &read)
+{
+    return this->Run(board_pending_, read);
+}
+
+bool TelemetryRefresh::Run(std::shared_future<bool> &pending, const Read &read)
+{
+    std::promise<bool> promise;
+    std::shared_future<bool> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(pending.valid())
+        {
+            //same read already in flight
+            result = pending;
+        }
+        else
+        {
+            pending = promise.get_future().share();
+        }
+    }
+    if(result.valid())
+    {
+        return result.get();
+    }
+
+    bool valid = read();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending = std::shared_future<bool>();
+    }
+    promise.set_value(valid);
+    return valid;
+}
@@ -0,0 +1,86 @@
+#include "telemetry_scheduler.hpp"
+
+TelemetryScheduler::TelemetryScheduler()
+{
+    for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+    {
+        classes_[i].esc_period_s = 0.0;
+        classes_[i].next_s = 0.0;
+        classes_[i].next_esc = 0;
+    }
+}
+
+void TelemetryScheduler::SetRate(uint8_t data_class, double rate_hz, double now_s)
+{
+    ClassState &state = classes_[data_class];
+    if(rate_hz <= 0.0)
+    {
+        state.esc_period_s = 0.0;
+        return;
+    }
+
+    state.esc_period_s = 1.0 / (rate_hz * TELEMETRY_ESC_COUNT);
+    state.next_s = now_s + state.esc_period_s;
+}
+
+double TelemetryScheduler::GetRate(uint8_t data_class) const
+{
+    const ClassState &state = classes_[data_class];
+    if(state.esc_period_s <= 0.0)
+    {
+        return 0.0;
+    }
+    return 1.0 / (state.esc_period_s * TELEMETRY_ESC_COUNT);
+}
+
+bool TelemetryScheduler::Next(double now_s, uint8_t &data_class, uint8_t &esc_index)
+{
+    int selected = -1;
+    for(uint8_t i = 0; i < TELEMETRY_CLASS_COUNT; i++)
+    {
+        const ClassState &state = classes_[i];
+        if(state.esc_period_s <= 0.0 || state.next_s > now_s)
+        {
+            continue;
+        }
+        if(selected < 0 || state.next_s < classes_[selected].next_s)
+        {
+            selected = i;
+        }
+    }
+
+    if(selected < 0)
+    {
+        return false;
+    }
+
+    ClassState &state = classes_[selected];
+    data_class = selected;
+    esc_index = state.next_esc;
+    state.next_esc = (state.next_esc + 1) % TELEMETRY_ESC_COUNT;
+
+    //keep cadence, but do not try to catch up after long stall
+    state.next_s += state.esc_period_s;
+    if(state.next_s < now_s)
+    {
+        state.next_s = now_s + state.esc_period_s;
+    }
+    return true;
+}
+
+const char *TelemetryScheduler::ClassName(uint8_t data_class)
+{
+    switch(data_class)
+    {
+        case TELEMETRY_ERROR_LOG:
+            return "error_log";
+        case TELEMETRY_DATA_LOG:
+            return "data_log";
+        case TELEMETRY_DEVICE_INFO:
+            return "device_info";
+        case TELEMETRY_RESISTANCE:
+            return "resistance";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,133 @@
+#include "telemetry_store.hpp"
+
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+bool TelemetrySnapshot::IsEscFresh(uint8_t data_class, uint8_t esc_index, const ros::Time &now, double max_age_s) const
+{
+    uint8_t status;
+    ros::Time captured;
+    switch(data_class)
+    {
+        case TELEMETRY_ERROR_LOG:
+            status = esc_error_log_status;
+            captured = esc_error_log_stamp[esc_index];
+            break;
+        case TELEMETRY_DATA_LOG:
+            status = esc_data_log_status;
+            captured = esc_data_log_stamp[esc_index];
+            break;
+        case TELEMETRY_DEVICE_INFO:
+            status = esc_device_info_status;
+            captured = esc_device_info_stamp[esc_index];
+            break;
+        case TELEMETRY_RESISTANCE:
+            status = esc_resistance_status;
+            captured = esc_resistance_stamp[esc_index];
+            break;
+        default:
+            return false;
+    }
+
+    if(!(status & (1 << esc_index)))
+    {
+        return false;
+    }
+    return (now - captured).toSec() <= max_age_s;
+}
+
+bool TelemetrySnapshot::IsBoardFresh(const ros::Time &now, double max_age_s) const
+{
+    return board_device_info_status && (now - board_device_info_stamp).toSec() <= max_age_s;
+}
+
+TelemetryStore::TelemetryStore()
+    :sequence_(0)
+{
+    for(uint8_t i = 0; i < TELEMETRY_ESC_COUNT; i++)
+    {
+        ERROR_WARN_LOG er_log = ERROR_WARN_LOG_INIT;
+        working_.esc_error_log[i] = er_log;
+        memset(&working_.esc_data_log[i], 0, sizeof(RUN_DATA_Struct));
+        memset(&working_.esc_device_info[i], 0, sizeof(ADB_DEVICE_INFO));
+        memset(&working_.esc_resistance[i], 0, sizeof(RESISTANCE_STRUCT));
+    }
+    working_.esc_error_log_status = 0x00;
+    working_.esc_data_log_status = 0x00;
+    working_.esc_device_info_status = 0x00;
+    working_.esc_resistance_status = 0x00;
+    memset(&working_.board_device_info, 0, sizeof(POWER_BOARD_INFO));
+    working_.board_device_info_status = false;
+    working_.power_board_status = program_state_run;
+
+    this->StoreShared(working_);
+}
+
+TelemetrySnapshot &TelemetryStore::Edit()
+{
+    return working_;
+}
+
+void TelemetryStore::Publish()
+{
+    working_.stamp = ros::Time::now();
+
+    //odd sequence marks write in progress
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    this->StoreShared(working_);
+
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+TelemetrySnapshot TelemetryStore::Read() const
+{
+    TelemetrySnapshot snapshot;
+    while(true)
+    {
+        uint32_t before = sequence_.load(std::memory_order_acquire);
+        if(before & 0x01)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        this->LoadShared(snapshot);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(sequence_.load(std::memory_order_relaxed) == before)
+        {
+            return snapshot;
+        }
+    }
+}
+
+void TelemetryStore::StoreShared(const TelemetrySnapshot &snapshot)
+{
+    //word by word relaxed stores, ordering is given by sequence
+    const uint8_t *bytes = (const uint8_t*)&snapshot;
+    for(size_t i = 0; i < TELEMETRY_STORE_WORDS; i++)
+    {
+        uint64_t word = 0;
+        size_t offset = i * sizeof(uint64_t);
+        size_t size = std::min(sizeof(uint64_t), sizeof(TelemetrySnapshot) - offset);
+        memcpy(&word, bytes + offset, size);
+        shared_[i].store(word, std::memory_order_relaxed);
+    }
+}
+
+void TelemetryStore::LoadShared(TelemetrySnapshot &snapshot) const
+{
+    //torn words are possible, caller throws copy away when sequence changed
+    uint8_t *bytes = (uint8_t*)&snapshot;
+    for(size_t i = 0; i < TELEMETRY_STORE_WORDS; i++)
+    {
+        uint64_t word = shared_[i].load(std::memory_order_relaxed);
+        size_t offset = i * sizeof(uint64_t);
+        size_t size = std::min(sizeof(uint64_t), sizeof(TelemetrySnapshot) - offset);
+        memcpy(bytes + offset, &word, size);
+    }
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <cstring>
+
+#include "utils.hpp"
+
+//integer path replaces ConvertFixedToFloat, results have to be bit-identical
+template<class FORMAT>
+static uint64_t CountMismatches(Utils::NumberIq iq, uint8_t decimal_places, uint64_t count)
+{
+    uint64_t mismatches = 0;
+    for(uint64_t number = 0; number < count; number++)
+    {
+        float expected = Utils::ConvertFixedToFloat((uint32_t)number, iq, decimal_places);
+        float result = FORMAT::ToFloat((uint32_t)number);
+        if(memcmp(&expected, &result, sizeof(float)) != 0)
+        {
+            if(mismatches == 0)
+            {
+                ADD_FAILURE() << "first mismatch at 0x" << std::hex << number << ": " << result << " != " << expected;
+            }
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+TEST(FixedPoint, MotorCurrentMatchesFloatPathForAllInputs)
+{
+    EXPECT_EQ(0u, CountMismatches<Utils::MotorCurrent>(Utils::I4Q8, 0, 1ull << 32));
+}
+
+TEST(FixedPoint, DecimalPlacesMatchFloatPathForAllInputs)
+{
+    EXPECT_EQ(0u, (CountMismatches<Utils::FixedPoint<4, 8, 1> >(Utils::I4Q8, 1, 1ull << 32)));
+    EXPECT_EQ(0u, (CountMismatches<Utils::FixedPoint<4, 8, 2> >(Utils::I4Q8, 2, 1ull << 32)));
+    EXPECT_EQ(0u, (CountMismatches<Utils::FixedPoint<4, 8, 3> >(Utils::I4Q8, 3, 1ull << 32)));
+}
+
+TEST(FixedPoint, ConstantsFollowFormat)
+{
+    EXPECT_EQ(0x800u, (Utils::FixedPoint<4, 8>::SignMask()));
+    EXPECT_EQ(0x8000u, (Utils::FixedPoint<1, 15>::SignMask()));
+    EXPECT_EQ(0x80000000u, (Utils::FixedPoint<16, 16>::SignMask()));
+    EXPECT_FLOAT_EQ(1.0f / 256.0f, (Utils::FixedPoint<8, 8>::Scale()));
+    EXPECT_DOUBLE_EQ(1000.0, (Utils::FixedPoint<4, 8>::Pow10(3)));
+}
+
+TEST(FixedPoint, SignIsExtendedFromTopBit)
+{
+    EXPECT_FLOAT_EQ(-1.0f, (Utils::FixedPoint<4, 8>::ToFloat(0xf00)));
+    EXPECT_FLOAT_EQ(7.99609375f, (Utils::FixedPoint<4, 8>::ToFloat(0x7ff)));
+    EXPECT_FLOAT_EQ(-8.0f, (Utils::FixedPoint<4, 8>::ToFloat(0x800)));
+    EXPECT_FLOAT_EQ(-1.0f, (Utils::FixedPoint<1, 15>::ToFloat(0x8000)));
+    EXPECT_FLOAT_EQ(-0.5f, (Utils::FixedPoint<16, 16>::ToFloat(0xffff8000)));
+}
+
+TEST(FixedPoint, BatchMatchesSingleConversion)
+{
+    uint32_t numbers[] = {0x000, 0x001, 0x7ff, 0x800, 0xfff, 0x180};
+    float results[sizeof(numbers) / sizeof(numbers[0])];
+    Utils::MotorCurrent::ToFloat(numbers, results, sizeof(numbers) / sizeof(numbers[0]));
+    for(size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++)
+    {
+        EXPECT_EQ(Utils::MotorCurrent::ToFloat(numbers[i]), results[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
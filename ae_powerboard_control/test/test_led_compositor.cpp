@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include "led_compositor.hpp"
+
+TEST(LedCompositor, LayerIsReservedForItsOwner)
+{
+    LedCompositor compositor;
+    EXPECT_FALSE(compositor.Claim(LED_LAYER_STATUS, "mission"));
+    EXPECT_FALSE(compositor.Claim(LED_LAYER_STATUS, "mission"));
+    EXPECT_TRUE(compositor.Claim(LED_LAYER_STATUS, "other"));
+
+    compositor.Release(LED_LAYER_STATUS);
+    EXPECT_FALSE(compositor.Claim(LED_LAYER_STATUS, "other"));
+}
+
+TEST(LedCompositor, EmptyOwnerIsRefused)
+{
+    LedCompositor compositor;
+    EXPECT_TRUE(compositor.Claim(LED_LAYER_SAFETY, ""));
+
+    //refused claim does not reserve layer
+    EXPECT_FALSE(compositor.Claim(LED_LAYER_SAFETY, "safety"));
+    EXPECT_TRUE(compositor.Claim(LED_LAYER_SAFETY, ""));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
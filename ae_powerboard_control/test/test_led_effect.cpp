@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include "led_effect.hpp"
+
+#define TEST_TICK_PERIOD_S  0.1
+
+static LedEffectStep Step(uint32_t ticks, const COLOR &color)
+{
+    LedEffectStep step;
+    step.ticks = ticks;
+    step.pattern.assign(1, color);
+    return step;
+}
+
+static void Compile(const LedEffectDescription &description, LedEffect &effect)
+{
+    std::string error;
+    ASSERT_FALSE(LedEffect::Compile(description, effect, error)) << error;
+    effect.tick_period_s = TEST_TICK_PERIOD_S;
+}
+
+static ros::Time AtTick(const ros::Time &start, uint32_t tick)
+{
+    return start + ros::Duration(tick * TEST_TICK_PERIOD_S + TEST_TICK_PERIOD_S / 2);
+}
+
+//front left blinks every tick, add holds one color, so second frame changes only front left
+static LedEffectDescription BlinkDescription()
+{
+    COLOR red = {255, 0, 0};
+    COLOR green = {0, 255, 0};
+    COLOR blue = {0, 0, 255};
+
+    LedEffectDescription description;
+    description.id = 1;
+    description.name = "blink";
+    description.leds_count = 1;
+    description.loop = false;
+    description.tracks.resize(2);
+    description.tracks[0].mask = LED_CHANNEL_MASK(LED_CHANNEL_FL);
+    description.tracks[0].steps.push_back(Step(1, red));
+    description.tracks[0].steps.push_back(Step(1, green));
+    description.tracks[1].mask = LED_CHANNEL_MASK(LED_CHANNEL_AD);
+    description.tracks[1].steps.push_back(Step(2, blue));
+    return description;
+}
+
+TEST(LedEffectPlayer, SuccessiveFramesHoldOnlyTheirChannels)
+{
+    LedEffect effect;
+    Compile(BlinkDescription(), effect);
+
+    LedEffectPlayer player;
+    LedFrame frame;
+    ros::Time start(100.0);
+    player.Start(&effect, start);
+
+    ASSERT_TRUE(player.Tick(AtTick(start, 0), frame));
+    EXPECT_EQ(LED_CHANNEL_MASK(LED_CHANNEL_FL) | LED_CHANNEL_MASK(LED_CHANNEL_AD), frame.mask);
+
+    ASSERT_TRUE(player.Tick(AtTick(start, 1), frame));
+    EXPECT_EQ(LED_CHANNEL_MASK(LED_CHANNEL_FL), frame.mask);
+    EXPECT_FALSE(frame.update_count);
+    ASSERT_EQ(1u, frame.colors[LED_CHANNEL_FL].size());
+    EXPECT_EQ(255, frame.colors[LED_CHANNEL_FL][0].g);
+}
+
+TEST(LedEffectPlayer, NextEffectDoesNotRepeatChannelsOfPreviousOne)
+{
+    LedEffect blink;
+    Compile(BlinkDescription(), blink);
+
+    COLOR white = {255, 255, 255};
+    LedEffectDescription description;
+    description.id = 2;
+    description.name = "front_right";
+    description.leds_count = 1;
+    description.loop = true;
+    description.tracks.resize(1);
+    description.tracks[0].mask = LED_CHANNEL_MASK(LED_CHANNEL_FR);
+    description.tracks[0].steps.push_back(Step(1, white));
+    LedEffect front_right;
+    Compile(description, front_right);
+
+    LedEffectPlayer player;
+    LedFrame frame;
+    ros::Time start(100.0);
+    player.Start(&blink, start);
+    ASSERT_TRUE(player.Tick(AtTick(start, 0), frame));
+
+    //frame is reused as in main timer callback
+    player.Start(&front_right, start);
+    ASSERT_TRUE(player.Tick(AtTick(start, 0), frame));
+    EXPECT_EQ(LED_CHANNEL_MASK(LED_CHANNEL_FR), frame.mask);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}